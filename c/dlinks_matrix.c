@@ -3,49 +3,96 @@
 #include <stdlib.h>
 #include "dlinks_matrix.h"
 
+#define MIN_BLOCK_NODES 256
 
 void init_matrix(Matrix*);
+void reserve_nodes(Matrix*, int);
+Node* init_node(Node*, Node*, int, int, int, int, int);
 Node* create_node(Matrix*, int, int, int, int, int);
 
 //Returns initialized Matrix struct of size [num_rows x num_cols]
 Matrix* create_matrix(int num_rows, int num_cols){
+    return create_matrix_sized(num_rows, num_cols, 0);
+}
+
+//Returns initialized Matrix struct of size [num_rows x num_cols]
+//with room for num_nodes nodes in its first block
+Matrix* create_matrix_sized(int num_rows, int num_cols, int num_nodes){
     Matrix* mx = malloc(sizeof(Matrix));
-    mx->rows     = malloc(sizeof(Node*) * num_rows);
-    mx->cols     = malloc(sizeof(Node*) * num_cols);
-    mx->num_rows = num_rows;
-    mx->num_cols = num_cols;
-    mx->solution = create_stack();
+    mx->rows       = malloc(sizeof(Node*) * num_rows);
+    mx->cols       = malloc(sizeof(Node*) * num_cols);
+    mx->headers    = malloc(sizeof(Node) * (1 + num_rows + num_cols + num_rows+1));
+    mx->blocks     = NULL;
+    mx->free_nodes = NULL;
+    mx->num_rows   = num_rows;
+    mx->num_cols   = num_cols;
+    mx->solution   = create_stack(num_cols); //every row of a cover covers a column
     init_matrix(mx);
+    if(num_nodes > 0) { reserve_nodes(mx, num_nodes); }
     return mx;
 }
 
+//make room for n more nodes in the current block of the matrix
+//a new block is at least twice the size of the last one
+void reserve_nodes(Matrix* mx, int n){
+    node_block* block = mx->blocks;
+    if(block != NULL && block->size - block->used >= n) { return; }
+    int size = block != NULL ? 2*block->size : MIN_BLOCK_NODES;
+    if(size < n) { size = n; }
+    node_block* new_block = malloc(sizeof(node_block) + sizeof(Node) * size);
+    new_block->next = block;
+    new_block->size = size;
+    new_block->used = 0;
+    mx->blocks = new_block;
+}
+
+//link uncovered column col at the head of the list of its count
+static inline void link_column(Matrix* mx, Node* col){
+    Node* list  = &mx->counts[col->count];
+    col->right  = list->right;
+    col->left   = list;
+    list->right->left = col;
+    list->right = col;
+}
+
+//move uncovered column col to the list of its new count
+static inline void relink_column(Matrix* mx, Node* col){
+    col->right->left = col->left;
+    col->left->right = col->right;
+    link_column(mx, col);
+}
+
 //Insert node into matrix at row, col
 //If a node already exists at this position, change value
 void insert_node(Matrix* mx, int row, int col, int value){
     assert(row >= 0 && col >= 0 && row < mx->num_rows && col < mx->num_cols);
-    
-    //ceate new node
-    Node* new_node = create_node(mx, row, col, 1, value, -1);
 
-    //iterate through row to find correct placement of node in row
+    //find the node left of the new one in the row
+    //nodes are usually inserted in increasing order, so try the end of the row first
     Node* itr   = mx->rows[row];
     Node* start = itr;
-    while(itr->right != start && itr->right->col < col) { itr = itr->right; }
+    if(start->left->col < col) { itr = start->left; }
+    else { while(itr->right != start && itr->right->col < col) { itr = itr->right; } }
     //if node at this position already exists, reassign value and leave
     if(itr->right->col == col){
         itr->right->value = value;
         return;
     }
+
+    //ceate new node
+    Node* new_node = create_node(mx, row, col, 1, value, -1);
+
     //reassign left and right pointers
     new_node->right       = itr->right;
     new_node->left        = itr;
     itr->right            = new_node;
     new_node->right->left = new_node;
 
-    //iterate through column to find correct placement of node in column
+    //find the node above the new one in the column, trying the bottom of the column first
     itr   = mx->cols[col];
     start = itr;
-    while(itr->down != start && itr->down->row < row) { itr = itr->down; }
+    if(start->up->row < row) { itr = start->up; }
+    else { while(itr->down != start && itr->down->row < row) { itr = itr->down; } }
     //reassign up and down pointers
     new_node->down     = itr->down;
     new_node->up       = itr;
@@ -54,9 +101,45 @@ void insert_node(Matrix* mx, int row, int col, int value){
 
     mx->rows[row]->count++;
     mx->cols[col]->count++;
+    if(!column_is_covered(mx->cols[col])) { relink_column(mx, mx->cols[col]); }
 
 }
 
+//Insert whole rows into the matrix, all with value 1
+//list i holds the columns of row row_ids[i] in increasing order, cols[starts[i]] to cols[starts[i+1]-1]
+//a node is appended to its row and column in one step when it goes to the end of both,
+//as with rows loaded in increasing order into empty rows, so loading takes O(nodes);
+//any other node is placed by insert_node
+void load_rows(Matrix* mx, int num_lists, const int* row_ids, const int* starts, const int* cols){
+    reserve_nodes(mx, starts[num_lists] - starts[0]);
+    for(int i=0; i<num_lists; i++){
+        int row = row_ids[i];
+        assert(row >= 0 && row < mx->num_rows);
+        Node* row_head = mx->rows[row];
+        for(int k=starts[i]; k<starts[i+1]; k++){
+            int col = cols[k];
+            assert(col >= 0 && col < mx->num_cols);
+            Node* col_head = mx->cols[col];
+            if(row_head->left->col >= col || col_head->up->row >= row){
+                insert_node(mx, row, col, 1);
+                continue;
+            }
+            Node* new_node = create_node(mx, row, col, 1, 1, -1);
+            new_node->left        = row_head->left;
+            new_node->right       = row_head;
+            row_head->left->right = new_node;
+            row_head->left        = new_node;
+            new_node->up          = col_head->up;
+            new_node->down        = col_head;
+            col_head->up->down    = new_node;
+            col_head->up          = new_node;
+            row_head->count++;
+            col_head->count++;
+            if(!column_is_covered(col_head)) { relink_column(mx, col_head); }
+        }
+    }
+}
+
 //Remove node at row, col
 //If no node exists at this position, do nothing
 void remove_node(Matrix* mx, int row, int col){
@@ -76,7 +159,10 @@ void remove_node(Matrix* mx, int row, int col){
 
     mx->rows[row]->count--;
     mx->cols[col]->count--;
-    free(itr);
+    if(!column_is_covered(mx->cols[col])) { relink_column(mx, mx->cols[col]); }
+    //keep the node for the next insert
+    itr->right     = mx->free_nodes;
+    mx->free_nodes = itr;
 }
 
 //print current matrix
@@ -84,7 +170,9 @@ void remove_node(Matrix* mx, int row, int col){
 void print_matrix(Matrix* mx){
     Node* vert_itr, *horiz_itr;
     printf(uln"R| ");
-    for(horiz_itr=mx->root->right; horiz_itr!=mx->root; horiz_itr=horiz_itr->right) { printf("%d ", horiz_itr->col); }
+    for(int j=0; j<mx->num_cols; j++){
+        if(!column_is_covered(mx->cols[j])) { printf("%d ", j); }
+    }
     printf(res"\n");
     for(vert_itr=mx->root->down; vert_itr!=mx->root; vert_itr=vert_itr->down){
         printf("%c| ", vert_itr->row+65);
@@ -104,28 +192,21 @@ void print_matrix(Matrix* mx){
 //free remaining matrix memory
 void delete_matrix(Matrix* mx){
     delete_stack(mx->solution);
-    int i;
-    Node* itr, *start;
-    for(i=0; i<mx->num_cols; i++) { free(mx->cols[i]); }
-    for(i=0; i<mx->num_rows; i++){
-        itr   = mx->rows[i]->right;
-        start = mx->rows[i]->right;
-        while(itr->right != start){
-            itr = itr->right;
-            free(itr->left);
-        }
-        free(itr);
+    node_block* block = mx->blocks;
+    while(block != NULL){
+        node_block* next = block->next;
+        free(block);
+        block = next;
     }
+    free(mx->headers);
     free(mx->rows);
     free(mx->cols);
-    free(mx->root);
     free(mx);
 
 }
 
-//Instantiate and initialize a Matrix Node
-Node* create_node(Matrix* mx, int row, int col, int type, int value, int count){
-    Node* node = malloc(sizeof(Node));
+//Initialize a Matrix Node in column
+Node* init_node(Node* node, Node* column, int row, int col, int type, int value, int count){
     node->row    = row;
     node->col    = col;
     node->type   = type;
@@ -135,21 +216,35 @@ Node* create_node(Matrix* mx, int row, int col, int type, int value, int count){
     node->down   = NULL;
     node->left   = NULL;
     node->right  = NULL;
-    node->matrix = mx;
+    node->column = column;
     return node;
 }
 
+//Instantiate and initialize a Matrix Node
+//nodes are taken from the removed ones first, then from the current block
+Node* create_node(Matrix* mx, int row, int col, int type, int value, int count){
+    Node* node = mx->free_nodes;
+    if(node != NULL) { mx->free_nodes = node->right; }
+    else{
+        reserve_nodes(mx, 1);
+        node = &mx->blocks->nodes[mx->blocks->used++];
+    }
+    return init_node(node, col >= 0 ? mx->cols[col] : mx->root, row, col, type, value, count);
+}
+
 //Initialize the Row and Column headers of the Matrix
 void init_matrix(Matrix* mx){
-    mx->root = create_node(mx, -1, -1, 3, -1, -1); //create root of matrix
+    Node* header = mx->headers;
+    mx->root = init_node(header, header, -1, -1, 3, -1, -1); //create root of matrix
+    header++;
     //instantiate array of row header nodes
-    mx->rows[0]        = create_node(mx, 0, -1, 2, -1, 0);
+    mx->rows[0]        = init_node(header++, mx->root, 0, -1, 2, -1, 0);
     mx->rows[0]->right = mx->rows[0];
     mx->rows[0]->left  = mx->rows[0];
     mx->rows[0]->up    = mx->root;
     mx->root->down = mx->rows[0];
     for(int i=1; i<mx->num_rows; i++){
-        Node* node = create_node(mx, i, -1, 2, -1, 0);
+        Node* node = init_node(header++, mx->root, i, -1, 2, -1, 0);
         node->up = mx->rows[i-1];
         mx->rows[i-1]->down = node;
         node->right = node;
@@ -159,22 +254,27 @@ void init_matrix(Matrix* mx){
     mx->rows[mx->num_rows-1]->down = mx->root; //last row_header.down points to root
     mx->root->up = mx->rows[mx->num_rows-1]; //root.up points to last row_header
 
-    //instantiate array of column header nodes
-    mx->cols[0]       = create_node(mx, -1, 0, 2, -1, 0);
-    mx->cols[0]->down = mx->cols[0];
-    mx->cols[0]->up   = mx->cols[0];
-    mx->cols[0]->left = mx->root;
-    mx->root->right = mx->cols[0];
-    for(int i=1; i<mx->num_cols; i++){
-        Node* node = create_node(mx, -1, i, 2, -1, 0);
-        node->left = mx->cols[i-1];
+    //instantiate array of column header nodes, all in the list of count 0
+    Node* cols = header;
+    header += mx->num_cols;
+    mx->counts = header;
+    for(int i=0; i<=mx->num_rows; i++){
+        Node* list = init_node(header++, NULL, -1, -1, 4, -1, i);
+        list->right = list;
+        list->left  = list;
+    }
+    for(int i=0; i<mx->num_cols; i++){
+        Node* node = init_node(&cols[i], &cols[i], -1, i, 2, -1, 0);
         node->down = node;
         node->up   = node;
-        mx->cols[i-1]->right = node;
-        mx->cols[i]          = node;
+        link_column(mx, node);
+        mx->cols[i] = node;
     }
-    mx->cols[mx->num_cols-1]->right = mx->root; //last col_header.right points to root
-    mx->root->left  = mx->cols[mx->num_cols-1]; //root.left points to last col_header
+    //the root is the column of the row headers, but in no count list: its right node
+    //does not link back to it, so cover and uncover never move it, like a covered column
+    mx->root->right = mx->counts;
+    mx->root->left  = mx->counts;
+    mx->num_uncovered = mx->num_cols;
     mx->root->count = 0;
     mx->solved = false;
 }
@@ -182,27 +282,21 @@ void init_matrix(Matrix* mx){
 //*** Algorithm X ***
 
 //return column header of column with least number of Nodes in matrix
+//the head of the first non-empty count list, the column whose count changed last
 Node* select_min_column(Matrix* matrix){
     if(matrix_is_empty(matrix)) { return matrix->root; }
-    Node* itr = matrix->root->right;
-    Node* min_node = itr;
-    int min_count  = itr->count;
-    while(itr->right != matrix->root){
-        itr = itr->right;
-        if(itr->count < min_count){
-            min_node  = itr;
-            min_count = itr->count;
-        }
-    }
-    return min_node;
+    Node* list = matrix->counts;
+    while(list->right == list) { list++; }
+    return list->right;
 }
 
 //cover a column of node n for algorithm x
-void cover(Node* n){
+void cover(Matrix* matrix, Node* n){
     Node* col = column_of(n);
     //unlink left and right neighbors of col from col
     col->right->left = col->left;
     col->left->right = col->right;
+    matrix->num_uncovered--;
     //iterate through each Node in col top to bottom
     for(Node* vert_itr=col->down; vert_itr!=col; vert_itr=vert_itr->down){
         //iterate through row left to right
@@ -210,13 +304,16 @@ void cover(Node* n){
         for(Node* horiz_itr=vert_itr->right; horiz_itr!=vert_itr; horiz_itr=horiz_itr->right){
             horiz_itr->up->down = horiz_itr->down;
             horiz_itr->down->up = horiz_itr->up;
-            column_of(horiz_itr)->count--;
+            Node* cn = column_of(horiz_itr);
+            cn->count--;
+            //if column cn is not covered - move it to its new list
+            if(cn->right->left == cn) { relink_column(matrix, cn); }
         }
     }
 }
 
 //uncover a column of node n for algorithm x
-void uncover(Node* n){
+void uncover(Matrix* matrix, Node* n){
     Node* col=column_of(n);
     //iterate through each 1 in col bottom to top
     for(Node* vert_itr=col->up; vert_itr!=col; vert_itr=vert_itr->up){
@@ -225,17 +322,36 @@ void uncover(Node* n){
         for(Node* horiz_itr=vert_itr->left; horiz_itr!=vert_itr; horiz_itr=horiz_itr->left){
             horiz_itr->up->down = horiz_itr;
             horiz_itr->down->up = horiz_itr;
-            column_of(horiz_itr)->count++;
+            Node* cn = column_of(horiz_itr);
+            cn->count++;
+            if(cn->right->left == cn) { relink_column(matrix, cn); }
         }
     }
-    //relink left and right neighbors of col to col
-    col->right->left = col;
-    col->left->right = col;
+    //relink col at the head of the list of its count
+    link_column(matrix, col);
+    matrix->num_uncovered++;
+}
+
+//cover the columns of the row of node n, left to right, skipping the row header
+static inline void cover_row(Matrix* matrix, Node* n){
+    Node* horiz_itr = n;
+    do{
+        if(horiz_itr->col >= 0) { cover(matrix, horiz_itr); }
+    }while((horiz_itr = horiz_itr->right) != n);
+}
+
+//uncover the columns of the row of node n, the reverse of cover_row
+static inline void uncover_row(Matrix* matrix, Node* n){
+    Node* horiz_itr = n->left;
+    do{
+        if(horiz_itr->col >= 0) { uncover(matrix, horiz_itr); }
+    }while((horiz_itr = horiz_itr->left) != n->left);
 }
 
 //search the toroidal matrix structure for an exact cover
+//iterative implementation, the partial solution is the only stack
 //returns true if exact cover is found, false otherwise
-//solutions LIFO will contain all rows making up the solution
+//solutions LIFO will contain a node of each row making up the solution
 bool alg_x_search(Matrix* matrix){
     //if matrix is empty then an exact cover exists, return true
     if(matrix_is_empty(matrix)) { return matrix->solved = true; }
@@ -244,33 +360,85 @@ bool alg_x_search(Matrix* matrix){
     //if selected column has 0 Nodes, then this branch has failed
     if(selected_col->count < 1) { return false; }
 
-    Node* vert_itr=selected_col->down;
-    Node* horiz_itr;
-    //iterate down from selected column head
-    while(vert_itr != selected_col && !matrix->solved){
+    Node* vert_itr = selected_col->down;
+    while(true){
         //add selected row to solutions LIFO
-        push_stack(matrix->solution, matrix->rows[vert_itr->row]);
+        push_stack(matrix->solution, vert_itr);
 
-        horiz_itr = vert_itr;
-        //iterate right from vertical iterator, cover each column
-        do{
-            if(horiz_itr->col >= 0) { cover(horiz_itr); } //skip column of row headers
-        }while((horiz_itr = horiz_itr->right) != vert_itr);
-
-        //search this matrix again after covering
-        //if solution found on this branch, leave loop and stop searching
-        if(alg_x_search(matrix)) { break; }
-
-        //solution not found on this iteration's branch, need to revert changes to matrix
-        //remove row from solutions, then uncover columns from this iteration
-        pop_stack(matrix->solution);
-        horiz_itr = vert_itr->left;
-        //iterate left from the last column that was covered, uncover each column
+        cover_row(matrix, vert_itr);
+
+        //if matrix is empty the solution is complete, leave it covered
+        if(matrix_is_empty(matrix)) { return matrix->solved = true; }
+        //otherwise continue down the column with least number of Nodes, unless it has none
+        selected_col = select_min_column(matrix);
+        if(selected_col->count > 0){
+            vert_itr = selected_col->down;
+            continue;
+        }
+
+        //branch failed, remove rows from solutions and uncover their columns
+        //until a row has a next row in its column
         do{
-            if(horiz_itr->col >= 0) { uncover(horiz_itr); } //skip column of row headers
-        }while((horiz_itr = horiz_itr->left) != vert_itr->left);
+            vert_itr = top_stack(matrix->solution);
+            if(vert_itr == NULL) { return false; }
+            pop_stack(matrix->solution);
+            uncover_row(matrix, vert_itr);
+            vert_itr = vert_itr->down;
+        }while(vert_itr == column_of(vert_itr));
+    }
+}
+
+//search the matrix for all exact covers, calling callback with the row indices of each one
+//as it is found; the search stops early when callback returns false or after limit covers
+//if limit > 0. With a NULL callback the covers are only counted.
+//the matrix is left as it was, so it can be searched again
+//returns the number of exact covers found
+long alg_x_enumerate(Matrix* matrix, solution_callback callback, void* data, long limit){
+    solution_stack* stack = matrix->solution;
+    int base   = stack->count;
+    long found = 0;
+    int* rows  = NULL;
+
+    //an empty matrix has one cover, with no rows
+    if(matrix_is_empty(matrix)){
+        if(callback != NULL) { callback(NULL, 0, data); }
+        return 1;
+    }
+    if(callback != NULL) { rows = malloc(sizeof(int) * stack->capacity); }
 
+    Node* vert_itr = select_min_column(matrix)->down;
+    while(true){
+        //a header means the rows of the column are exhausted, otherwise choose the row
+        if(vert_itr != column_of(vert_itr)){
+            push_stack(stack, vert_itr);
+            cover_row(matrix, vert_itr);
+            //continue down the column with least number of Nodes, unless the cover is complete
+            if(!matrix_is_empty(matrix)){
+                vert_itr = select_min_column(matrix)->down;
+                continue;
+            }
+            found++;
+            if(callback != NULL){
+                int num_rows = stack->count - base;
+                for(int i=0; i<num_rows; i++) { rows[i] = ((Node*)stack->data[base+i])->row; }
+                if(!callback(rows, num_rows, data)) { break; }
+            }
+            if(found == limit) { break; }
+        }
+
+        //remove the last row and go on with the next one of its column
+        if(stack->count == base) { break; }
+        vert_itr = top_stack(stack);
+        pop_stack(stack);
+        uncover_row(matrix, vert_itr);
         vert_itr = vert_itr->down;
     }
-    return matrix->solved;
+
+    //take back the rows still chosen when the search stopped early
+    while(stack->count > base){
+        uncover_row(matrix, top_stack(stack));
+        pop_stack(stack);
+    }
+    free(rows);
+    return found;
 }
\ No newline at end of file
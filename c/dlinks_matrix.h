@@ -10,37 +10,65 @@
 
 typedef struct _matrix Matrix;
 typedef struct _node Node;
+typedef struct _node_block node_block;
 
 //Data node for sparse matrix
 struct _node{
     int row, col, value, type, count;
     Node* up, *down, *left, *right;
-    Matrix* matrix;
+    Node* column; //header of the column, the root for row headers
+};
+
+//Contiguous block of nodes, the matrix hands out its nodes from a list of these
+struct _node_block{
+    node_block* next;
+    int size, used;
+    Node nodes[];
 };
 
 //Toroidally linked sparse matrix
+//the root and header nodes are one array, the data nodes come from the blocks
+//uncovered column headers are linked left and right in the list of their count,
+//counts[i] heading the columns with i nodes
 struct _matrix{
     Node** rows, **cols;
     Node* root;
+    Node* counts;
+    int num_uncovered;
+    Node* headers;
+    node_block* blocks;
+    Node* free_nodes; //removed nodes, linked by their right pointer
     int num_rows, num_cols;
     solution_stack* solution;
     bool solved;
 };
 
 Matrix* create_matrix(int num_rows, int num_cols);
+Matrix* create_matrix_sized(int num_rows, int num_cols, int num_nodes);
 void insert_node(Matrix* mx, int row, int col, int value);
+void load_rows(Matrix* mx, int num_lists, const int* row_ids, const int* starts, const int* cols);
 void remove_node(Matrix* mx, int row, int col);
 void print_matrix(Matrix* mx);
 void delete_matrix(Matrix* mx);
 bool alg_x_search(Matrix* mx);
 
+//Called by alg_x_enumerate with the rows of each exact cover, in the order they were chosen
+//return false to stop the search
+typedef bool (*solution_callback)(const int* rows, int num_rows, void* data);
+
+long alg_x_enumerate(Matrix* mx, solution_callback callback, void* data, long limit);
+
+//count the exact covers, up to limit if limit > 0, without building them
+static inline long alg_x_count(Matrix* mx, long limit){
+    return alg_x_enumerate(mx, NULL, NULL, limit);
+}
+
 static inline bool matrix_is_empty(Matrix* matrix){
-    return matrix->root->right == matrix->root;
+    return matrix->num_uncovered == 0;
 }
 
 static inline Node* column_of(Node* node){
-    if(node->col==-1) { return node->matrix->root; }
-    return node->matrix->cols[node->col];
+    return node->column;
 }
 
 static inline bool column_is_covered(Node* node){
@@ -1,24 +1,34 @@
 #ifndef LIFO_H
 #define LIFO_H
+#include <assert.h>
+#include <stddef.h>
 
-//Simple linked node based stack for holding solution to algorithm x
+//Array based stack for holding solution to algorithm x
+//sized when it is created, push and pop never allocate
 
-typedef struct _solution_node solution_node;
 typedef struct _solution_stack solution_stack;
 
-struct _solution_node {
-    void* data;
-    solution_node* next;
-};
-
 struct _solution_stack {
-    solution_node* head;
-    int count;
+    void** data;
+    int count, capacity;
 };
 
-solution_stack* create_stack();
-void push_stack(solution_stack* stack, void* data);
-void pop_stack(solution_stack* stack);
+solution_stack* create_stack(int capacity);
 void delete_stack(solution_stack* stack);
 
+static inline void push_stack(solution_stack* stack, void* data){
+    assert(stack->count < stack->capacity);
+    stack->data[stack->count++] = data;
+}
+
+static inline void pop_stack(solution_stack* stack){
+    if(stack->count < 1) { return; }
+    stack->count--;
+}
+
+//return the last pushed item, NULL if the stack is empty
+static inline void* top_stack(solution_stack* stack){
+    return stack->count > 0 ? stack->data[stack->count-1] : NULL;
+}
+
 #endif
\ No newline at end of file
@@ -30,30 +30,36 @@ Matrix* puzzle_to_matrix(int* sudoku_list, int dim){
     int num_rows  = dim*dim*dim;
     int num_cols  = dim*dim*4;
     int num_cells = dim*dim;
-    Matrix* matrix = create_matrix(num_rows, num_cols);
+    //rows as lists of their 4 columns, in increasing row order for load_rows
+    int* row_ids = malloc(sizeof(int) * num_rows);
+    int* starts  = malloc(sizeof(int) * (num_rows+1));
+    int* cols    = malloc(sizeof(int) * num_rows * 4);
+    int num_lists = 0;
 
-    int row = 0;
     //iterate through puzzle list
     for(int i=0; i<num_cells; i++){
         //if no value assigned to cell, populate all rows representing all possible candidate values for cell
-        if(sudoku_list[i] == 0){
-            for(int j=0; j<dim; j++){
-                row = i*dim+j;
-                insert_node(matrix, row, one_constraint(row, dim), 1);
-                insert_node(matrix, row, row_constraint(row, dim), 1);
-                insert_node(matrix, row, col_constraint(row, dim), 1);
-                insert_node(matrix, row, box_constraint(row, dim), 1);
-            }
-        }
         //otherwise only populate the row representing the known assigned value
-        else{
-            row = i*dim+sudoku_list[i]-1;
-            insert_node(matrix, row, one_constraint(row, dim), 1);
-            insert_node(matrix, row, row_constraint(row, dim), 1);
-            insert_node(matrix, row, col_constraint(row, dim), 1);
-            insert_node(matrix, row, box_constraint(row, dim), 1);
+        int first = sudoku_list[i] == 0 ? 0 : sudoku_list[i]-1;
+        int last  = sudoku_list[i] == 0 ? dim : sudoku_list[i];
+        for(int j=first; j<last; j++){
+            int row = i*dim+j;
+            int k   = 4*num_lists;
+            row_ids[num_lists]  = row;
+            starts[num_lists++] = k;
+            cols[k]   = one_constraint(row, dim);
+            cols[k+1] = row_constraint(row, dim);
+            cols[k+2] = col_constraint(row, dim);
+            cols[k+3] = box_constraint(row, dim);
         }
     }
+    starts[num_lists] = 4*num_lists;
+
+    Matrix* matrix = create_matrix_sized(num_rows, num_cols, 4*num_lists);
+    load_rows(matrix, num_lists, row_ids, starts, cols);
+    free(row_ids);
+    free(starts);
+    free(cols);
     return matrix;
 }
 
@@ -67,9 +73,9 @@ bool solve_puzzle(int* puzzle, int dim, int* solution){
     bool found = alg_x_search(matrix);
     if(found) { //decode solution stored in matrix.solution
         int index, value;
-        for(solution_node* itr=matrix->solution->head; itr!=NULL; itr=itr->next){
-            index = ((Node*)itr->data)->row / dim;
-            value = (((Node*)itr->data)->row % dim) + 1;
+        for(int i=0; i<matrix->solution->count; i++){
+            index = ((Node*)matrix->solution->data[i])->row / dim;
+            value = (((Node*)matrix->solution->data[i])->row % dim) + 1;
             solution[index] = value;
         }
     }
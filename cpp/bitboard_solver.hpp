@@ -0,0 +1,266 @@
+#pragma once
+
+#include "search_stats.hpp"
+
+//geometry of the 9x9 grid for the bitboard engine
+//houses 0-8 are the rows, 9-17 the columns and 18-26 the boxes
+struct BitBoardTables {
+	unsigned char house[81][3];		// the 3 houses of each cell
+	unsigned char cells[27][9];		// the 9 cells of each house
+	unsigned char peers[81][20];	// the 20 cells sharing a house with each cell
+	unsigned int house_bits[81];	// the 3 houses of each cell as a bit set
+
+	constexpr BitBoardTables() : house(), cells(), peers(), house_bits() {
+		int fill[27] = {};
+		for(int i=0; i<81; ++i) {
+			int r = i/9, c = i%9, b = (r/3)*3 + c/3;
+			house[i][0] = r; house[i][1] = 9+c; house[i][2] = 18+b;
+			house_bits[i] = (1U<<r) | (1U<<(9+c)) | (1U<<(18+b));
+			cells[r][fill[r]++] = i;
+			cells[9+c][fill[9+c]++] = i;
+			cells[18+b][fill[18+b]++] = i;
+		}
+		for(int i=0; i<81; ++i) {
+			int n = 0;
+			for(int j=0; j<81; ++j) {
+				if(j != i && (house[i][0] == house[j][0] || house[i][1] == house[j][1]
+							|| house[i][2] == house[j][2])) {
+					peers[i][n++] = j;
+				}
+			}
+		}
+	}
+};
+constexpr BitBoardTables bb_tables;
+
+//Candidate propagation solver for sudoku puzzles using bit masks
+//Optimized to only work with standard 9x9 puzzles
+//The candidates of each cell are kept as a 9-bit mask, the digits placed in each
+//row, column and box as a packed 9-bit set per house.
+//Naked and hidden singles are applied until nothing changes; the solver only
+//branches (on a cell with the fewest candidates) when propagation stalls.
+class BitBoard {
+	public:
+	class State {
+		public:
+		unsigned short cands[81];		// candidate digits of each cell, a single bit once solved
+		unsigned short placed[27];		// digits placed in each house
+		unsigned long long open[2];		// bit i set while cell i (cells 64-80 in open[1]) is unplaced
+		unsigned int dirty;				// houses with candidates changed since the last hidden single scan
+
+		inline void close(int cell) {
+			open[cell>>6] &= ~(1ULL<<(cell&63));
+		}
+	};
+
+	State stack[82];
+	State first;				// copy of the first solution when counting past it
+	const State *solution;		// the first solution found by search
+	unsigned char branch_cell[82];
+	unsigned char queue[81];
+	int givens;
+	int resolved;	// empty cells resolved by propagation before the first branch
+	int depth;
+	unsigned long branches;		// candidates tried by the last search
+	unsigned long backtracks;	// branches taken back by the last search
+	SEARCH_STAT(SearchStats stats;)
+
+	static inline bool is_single(unsigned int m) {
+		return (m & (m-1)) == 0;
+	}
+
+	//load a puzzle of 81 chars, '0' or '.' marking an empty cell, into state s
+	//the givens are queued, contradictions show up in the first propagate
+	//returns the number of givens queued
+	static inline int load(State &s, const unsigned char* puzzle, unsigned char* queue) {
+		for(int i=0; i<81; ++i) {
+			s.cands[i] = 0x1ff;
+		}
+		for(int i=0; i<27; ++i) {
+			s.placed[i] = 0;
+		}
+		s.open[0] = ~0ULL;
+		s.open[1] = (1ULL<<17)-1;
+		s.dirty = (1U<<27)-1;
+		int qlen = 0;
+		for(int i=0; i<81; ++i) {
+			if(puzzle[i] != '0' && puzzle[i] != '.') {
+				s.cands[i] = 1<<(puzzle[i]-'1');
+				queue[qlen++] = i;
+			}
+		}
+		return qlen;
+	}
+
+	//number of cells placed in state s
+	static inline int placed_cells(const State &s) {
+		return 81 - __builtin_popcountll(s.open[0]) - __builtin_popcountll(s.open[1]);
+	}
+
+	//place the qlen singles in queue and strike them from their peers,
+	//then look for hidden singles; repeat until nothing changes
+	//returns false on a contradiction
+	static inline bool propagate(State &s, unsigned char* queue, int qlen) {
+		while(true) {
+			while(qlen > 0) {
+				int cell = queue[--qlen];
+				unsigned short bit = s.cands[cell];
+				const unsigned char *h = bb_tables.house[cell];
+				if((s.placed[h[0]] | s.placed[h[1]] | s.placed[h[2]]) & bit) {
+					return false;
+				}
+				s.placed[h[0]] |= bit;
+				s.placed[h[1]] |= bit;
+				s.placed[h[2]] |= bit;
+				s.close(cell);
+				const unsigned char *p = bb_tables.peers[cell];
+				for(int i=0; i<20; ++i) {
+					unsigned short m = s.cands[p[i]];
+					if(m & bit) {
+						m &= ~bit;
+						if(m == 0) {
+							return false;
+						}
+						s.cands[p[i]] = m;
+						s.dirty |= bb_tables.house_bits[p[i]];
+						if(is_single(m)) {
+							queue[qlen++] = p[i];
+						}
+					}
+				}
+			}
+
+			//hidden singles: a digit with exactly one possible cell in a house
+			//only houses whose candidates changed since the last scan are checked
+			unsigned int d = s.dirty;
+			s.dirty = 0;
+			for(; d; d&=d-1) {
+				int hs = __builtin_ctz(d);
+				if(s.placed[hs] == 0x1ff) {
+					continue;
+				}
+				const unsigned char *c = bb_tables.cells[hs];
+				unsigned short once = 0, twice = 0;
+				for(int i=0; i<9; ++i) {
+					twice |= once & s.cands[c[i]];
+					once  |= s.cands[c[i]];
+				}
+				if(once != 0x1ff) {
+					return false;
+				}
+				unsigned short hidden = once & ~twice & ~s.placed[hs];
+				if(hidden == 0) {
+					continue;
+				}
+				for(int i=0; i<9 && hidden; ++i) {
+					unsigned short m = s.cands[c[i]] & hidden;
+					if(m && !is_single(s.cands[c[i]])) {
+						if(!is_single(m)) {
+							return false;
+						}
+						s.cands[c[i]] = m;
+						s.dirty |= bb_tables.house_bits[c[i]];
+						queue[qlen++] = c[i];
+						hidden &= ~m;
+					}
+				}
+			}
+			if(qlen == 0) {
+				return true;
+			}
+		}
+	}
+
+	//returns an open cell with the fewest candidates, -1 if all cells are placed
+	inline int select_cell(const State &s) {
+		int best = -1, best_count = 10;
+		for(int w=0; w<2; ++w) {
+			for(unsigned long long o=s.open[w]; o; o&=o-1) {
+				int cell = (w<<6) + __builtin_ctzll(o);
+				int n = __builtin_popcount(s.cands[cell]);
+				if(n < best_count) {
+					best = cell;
+					best_count = n;
+					if(n == 2) {
+						return best;
+					}
+				}
+			}
+		}
+		return best;
+	}
+
+	//depth first search with a copy of the state per branch
+	//counts solutions until limit are found or the search space is exhausted
+	//returns the number of solutions found, solution then points to the first of them
+	inline int search(int limit = 1) {
+		int found = 0;
+		depth = 0;
+		resolved = 0;
+		branches = backtracks = 0;
+		SEARCH_STAT(stats.reset();)
+		if(!propagate(stack[0], queue, givens)) {
+			return 0;
+		}
+		resolved = placed_cells(stack[0]) - givens;
+		while(true) {
+			State &s = stack[depth];
+			int cell = select_cell(s);
+			if(cell >= 0) {
+				//try the lowest candidate in a copy, keep the others in the current state
+				unsigned short bit = s.cands[cell] & -s.cands[cell];
+				s.cands[cell] &= ~bit;
+				s.dirty |= bb_tables.house_bits[cell];
+				branch_cell[depth] = cell;
+				stack[depth+1] = s;
+				stack[++depth].cands[cell] = bit;
+				++branches;
+				SEARCH_STAT(stats.depth(depth);)
+				queue[0] = cell;
+				if(propagate(stack[depth], queue, 1)) {
+					continue;
+				}
+			} else {
+				if(++found == limit) {
+					if(found == 1) {
+						solution = &s;
+					}
+					return found;
+				}
+				//keep the first solution and backtrack for the next one
+				if(found == 1) {
+					first = s;
+					solution = &first;
+				}
+			}
+			//continue with the remaining candidates of the parent
+			int qlen;
+			do {
+				if(--depth < 0) {
+					return found;
+				}
+				++backtracks;
+				qlen = 0;
+				cell = branch_cell[depth];
+				if(is_single(stack[depth].cands[cell])) {
+					queue[qlen++] = cell;
+				}
+			} while(!propagate(stack[depth], queue, qlen));
+		}
+	}
+};
+
+//solve a puzzle given as 81 chars with the bitboard engine
+//returns the number of solutions, counting stops at limit
+inline int solve_puzzle(BitBoard *bb, const unsigned char* puzzle, int limit = 1) {
+	bb->givens = BitBoard::load(bb->stack[0], puzzle, bb->queue);
+	return bb->search(limit);
+}
+
+//write the digits of the last solved puzzle as 81 chars
+inline void write_solution(BitBoard *bb, unsigned char* out) {
+	const BitBoard::State &s = *bb->solution;
+	for(int i=0; i<81; ++i) {
+		out[i] = __builtin_ctz(s.cands[i]) + '1';
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+//Checkpoint of a batch run, kept next to the output file as <output>.ckpt
+//The file holds one record of the job it belongs to (size and modification time of the input,
+//number of puzzles, output record size and count limit), followed by the slices the run splits the puzzles
+//into: each is solved in order and written at its own offset, and its entry counts the
+//puzzles from its start whose records are in the output file. OutputWriter saves it as the
+//written records advance, after syncing the output if the run has a durability policy, so
+//the counts never run ahead of the output that survives: a killed process leaves both in the
+//page cache, a run with syncs also survives a crash of the machine. Resuming continues each
+//slice after the puzzles counted.
+class Checkpoint {
+	public:
+	static const unsigned int interval_ms = 1000;	// time between saves while writing
+	static const uint16_t current_version = 3;
+	static const size_t max_slices = 4096;			// one per thread at most
+
+	//the puzzles [begin, end) of the input, those before next are in the output file
+	class Slice {
+		public:
+		uint64_t begin, next, end;
+	};
+
+	class Record {
+		public:
+		unsigned char magic[4] = { 'S', 'D', 'K', 'R' };
+		uint16_t version = current_version;
+		uint16_t record_size = 0;	// bytes per output record
+		uint32_t count_limit = 0;	// solutions counted per puzzle, 0 for the first one only
+		uint32_t unused = 0;		// spells out the padding, which the checksum covers
+		uint64_t input_size = 0;
+		int64_t input_mtime = 0;	// ns since the epoch
+		uint64_t npuzzles = 0;
+		uint64_t nslices = 0;		// slices following the record
+		uint64_t check = 0;
+
+		Record() {}
+
+		Record(const struct stat &input, size_t npuzzles, unsigned int record_size, unsigned int count_limit)
+			: record_size(record_size), count_limit(count_limit), input_size(input.st_size),
+			  input_mtime((int64_t)input.st_mtim.tv_sec*1000000000 + input.st_mtim.tv_nsec), npuzzles(npuzzles) {}
+
+		//fnv-1a of the bytes before check and of the slices
+		inline uint64_t checksum(const Slice *slices) const {
+			uint64_t h = fnv(14695981039346656037ull, this, offsetof(Record, check));
+			return fnv(h, slices, nslices*sizeof(Slice));
+		}
+
+		//same job as other, the slices aside
+		inline bool same_job(const Record &other) const {
+			return memcmp(magic, other.magic, 4) == 0 && version == other.version && record_size == other.record_size &&
+				count_limit == other.count_limit && input_size == other.input_size && input_mtime == other.input_mtime && npuzzles == other.npuzzles;
+		}
+	};
+	static_assert(sizeof(Record) == 56, "checkpoint record layout");
+
+	//checkpoint file of output file ofn for the job described by job
+	//sync: fdatasync the checkpoint after each save
+	Checkpoint(const char *ofn, const Record &job, bool sync) : fn(std::string(ofn) + ".ckpt"), rec(job), sync(sync) {
+		fd = open(fn.c_str(), O_RDWR|O_CREAT, 0664);
+		if ( fd == -1 ) {
+			fprintf(stderr, "Error opening checkpoint %s: %s\n", fn.c_str(), strerror(errno));
+		}
+	}
+
+	~Checkpoint() {
+		if ( fd != -1 ) {
+			close(fd);
+		}
+	}
+
+	Checkpoint(const Checkpoint &) = delete;
+	Checkpoint &operator=(const Checkpoint &) = delete;
+
+	inline const char *name() const { return fn.c_str(); }
+
+	//replace slices by those of an earlier run of the same job
+	//returns false, leaving slices as they are, if the checkpoint is missing, damaged or from
+	//another job
+	inline bool resume(std::vector<Slice> &slices) const {
+		Record old;
+		if ( fd == -1 || pread(fd, &old, sizeof(old), 0) != sizeof(old) ) {
+			return false;
+		}
+		std::vector<Slice> saved(old.nslices <= max_slices ? old.nslices : 0);
+		ssize_t bytes = saved.size()*sizeof(Slice);
+		bool valid = old.same_job(rec) && old.nslices == saved.size() &&
+			pread(fd, saved.data(), bytes, sizeof(old)) == bytes && old.check == old.checksum(saved.data());
+		for ( const Slice &sl : saved ) {
+			valid = valid && sl.begin <= sl.next && sl.next <= sl.end && sl.end <= rec.npuzzles;
+		}
+		if ( !valid ) {
+			fprintf(stderr, "Checkpoint %s is not from this job, starting over\n", fn.c_str());
+			return false;
+		}
+		slices = saved;
+		return true;
+	}
+
+	//start the run with slices (those resumed, or new ones) and save them at once, so a new run
+	//drops the counts of an old one before it truncates the output
+	inline void begin(const std::vector<Slice> &slices) {
+		save(slices);
+	}
+
+	//record how far each slice is in the output file
+	inline void save(const std::vector<Slice> &slices) {
+		if ( fd == -1 ) {
+			return;
+		}
+		rec.nslices = slices.size();
+		rec.check = rec.checksum(slices.data());
+		struct iovec iov[2] = { { &rec, sizeof(rec) }, { (void *)slices.data(), slices.size()*sizeof(Slice) } };
+		if ( pwritev(fd, iov, 2, 0) != (ssize_t)(sizeof(rec) + slices.size()*sizeof(Slice)) ) {
+			fprintf(stderr, "Error writing checkpoint %s: %s\n", fn.c_str(), strerror(errno));
+			return;
+		}
+		if ( sync && fdatasync(fd) == -1 ) {
+			fprintf(stderr, "Error syncing checkpoint %s: %s\n", fn.c_str(), strerror(errno));
+		}
+	}
+
+	private:
+	std::string fn;
+	Record rec;
+	bool sync;
+	int fd;
+
+	static inline uint64_t fnv(uint64_t h, const void *data, size_t size) {
+		const unsigned char *p = (const unsigned char *)data;
+		for ( size_t i=0; i<size; i++ ) {
+			h = (h ^ p[i]) * 1099511628211ull;
+		}
+		return h;
+	}
+};
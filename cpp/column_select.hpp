@@ -0,0 +1,92 @@
+#pragma once
+
+//Column selection policies for the DLinks search
+//The uncovered columns are kept in lists by node count, counts[i] heading the columns with
+//i nodes, so each policy takes a column from the first non-empty list; they only differ in
+//which of the columns of equal count is taken.
+//select returns 0 once all columns are covered; DL::max_count is the last list.
+//The policy of DLinks is picked at build time with -DDLINKS_SELECT=<policy>
+//(make SELECT=<policy>), MostRecent by default.
+
+//the head of the list: cover and uncover insert a column at the head when its count
+//changes, so this is the column whose count changed last
+struct MostRecent {
+	template<class DL>
+	static inline typename DL::Node* select(DL &dl) {
+		for(int i=0; i<=DL::max_count; ++i) {
+			if(dl.counts[i].right != &dl.counts[i]) {
+				return dl.counts[i].right;
+			}
+		}
+		return 0;
+	}
+};
+
+//the tail of the list: the column that has kept its count the longest
+struct LeastRecent {
+	template<class DL>
+	static inline typename DL::Node* select(DL &dl) {
+		for(int i=0; i<=DL::max_count; ++i) {
+			if(dl.counts[i].left != &dl.counts[i]) {
+				return dl.counts[i].left;
+			}
+		}
+		return 0;
+	}
+};
+
+//a cell constraint (the first ncells columns) if the list has one, branching on the digits of a cell
+struct PreferCell {
+	template<class DL>
+	static inline typename DL::Node* select(DL &dl) {
+		for(int i=0; i<=DL::max_count; ++i) {
+			typename DL::Node *head = &dl.counts[i];
+			if(head->right == head) {
+				continue;
+			}
+			for(typename DL::Node *c=head->right; c!=head; c=c->right) {
+				if(c < dl.cols[DL::ncells]) {
+					return c;
+				}
+			}
+			return head->right;
+		}
+		return 0;
+	}
+};
+
+//among the first few columns of the list, the one whose rows would leave the most
+//columns down to a single node, so the search runs into forced rows and dead ends sooner
+struct Lookahead {
+	static const int width = 4;		// columns of the list compared
+
+	template<class DL>
+	static inline typename DL::Node* select(DL &dl) {
+		for(int i=0; i<=DL::max_count; ++i) {
+			typename DL::Node *head = &dl.counts[i];
+			if(head->right == head) {
+				continue;
+			}
+			//no choice to make with 0 or 1 nodes
+			if(i < 2) {
+				return head->right;
+			}
+			typename DL::Node *best = head->right;
+			int best_score = -1, n = 0;
+			for(typename DL::Node *c=head->right; c!=head && n<width; c=c->right, ++n) {
+				int score = 0;
+				for(typename DL::Node *v=c->down; v!=c; v=v->down) {
+					for(typename DL::Node *h=v->right; h!=v; h=h->right) {
+						score += dl.cols[h->col]->count == 2;
+					}
+				}
+				if(score > best_score) {
+					best = c;
+					best_score = score;
+				}
+			}
+			return best;
+		}
+		return 0;
+	}
+};
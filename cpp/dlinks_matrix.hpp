@@ -1,9 +1,82 @@
 #pragma once
 
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+#include "bitboard_solver.hpp"
+#include "column_select.hpp"
+#include "search_stats.hpp"
+
+#ifndef DLINKS_SELECT
+#define DLINKS_SELECT MostRecent
+#endif
+
+//lookup tables for the 4 constraints of a sudoku with boxes of B x B cells
+//row r of the exact cover matrix places digit r%side in cell r/side, its nodes are in the
+//columns one[r] (a digit in the cell), row[r], col[r] and box[r] (the digit in each house)
+template<int B>
+struct CoverTables {
+	static const int side = B*B;			// cells per house, digits per cell
+	static const int ncells = side*side;
+	static const int nrows = side*ncells;
+	static const int npeers = 3*(side-1) - 2*(B-1);
+	int one[nrows], row[nrows], col[nrows], box[nrows];
+	short peers[ncells][npeers];			// the cells sharing a house with each cell
+
+	constexpr CoverTables() : one(), row(), col(), box(), peers() {
+		for(int r=0; r<nrows; ++r) {
+			int cell = r/side, d = r%side;
+			int gr = cell/side, gc = cell%side, gb = (gr/B)*B + gc/B;
+			one[r] = cell;
+			row[r] = ncells + gr*side + d;
+			col[r] = 2*ncells + gc*side + d;
+			box[r] = 3*ncells + gb*side + d;
+		}
+		for(int i=0; i<ncells; ++i) {
+			int n = 0;
+			for(int j=0; j<ncells; ++j) {
+				int ri = i/side, ci = i%side, rj = j/side, cj = j%side;
+				if(j != i && (ri == rj || ci == cj || (ri/B == rj/B && ci/B == cj/B))) {
+					peers[i][n++] = j;
+				}
+			}
+		}
+	}
+};
+template<int B>
+constexpr CoverTables<B> cover_tables{};
+
+//digit of a cell symbol: '1'-'9', then 'A'-'P' (or 'a'-'p') for 10-25 on larger grids
+//returns 0 for anything else, '0' and '.' mark empty cells
+inline int digit_of(unsigned char c) {
+	if ( c >= '1' && c <= '9' ) {
+		return c - '0';
+	}
+	c |= 0x20;
+	return c >= 'a' && c <= 'p' ? c - 'a' + 10 : 0;
+}
+
+//symbol of digit d, see digit_of
+inline unsigned char symbol_of(int d) {
+	return d <= 9 ? '0' + d : 'A' + d - 10;
+}
+
 //Toroidally linked matrix for solving sudoku puzzles via algorithm x
-//Optimized to only work with standard 9x9 puzzles
-class DLinks {
+//Sized at compile time for boxes of B x B cells: 9x9 puzzles by default, B=4 for 16x16 and
+//B=5 for 25x25, every loop bound and array is fixed for the size
+//Select is the column selection policy of the search, see column_select.hpp
+template<class Select, int B = 3>
+class DancingLinks {
 	public:
+	static const int box = B;
+	static const int side = B*B;			// cells per house, digits per cell
+	static const int ncells = side*side;
+	static const int ncols = 4*ncells;
+	static const int nrows = side*ncells;
+	static const int max_count = side;		// most nodes in a column, the count lists are 0..max_count
+	// candidates of a cell as a bit mask
+	typedef typename std::conditional<(side > 16), unsigned int, unsigned short>::type Mask;
+
 	typedef enum {
 		h,	// horizontal: left and right
 		v	// vertical: up and down
@@ -50,17 +123,23 @@ class DLinks {
 		}
 	};
 
-	Node cols[324][10];
-	Node counts[11];
-	Node* solution_stack[81];
+	Node cols[ncols][side+1];
+	Node counts[side+2];
+	Node* solution_stack[ncells];
+	Node* first_solution[ncells];	// copy of solution_stack when counting past the first solution
 	int solution_ptr;
+	unsigned long branches;		// rows tried by the last search
+	unsigned long backtracks;	// rows taken back by the last search
+	SEARCH_STAT(SearchStats stats;)
+	static const int template_rows = 512 * nrows / 729;	// copy the empty grid above this many candidate rows
+	int resolved;	// empty cells resolved by the propagation stage of solve_puzzle
 
 	inline void init() {
 		//initialize matrix
-		for(int i=0; i<324; ++i) {
+		for(int i=0; i<ncols; ++i) {
 			cols[i]->count = 0;
 		}
-		for(int i=0; i<11; ++i) {
+		for(int i=0; i<side+2; ++i) {
 			counts[i].selfloop_h();
 		}
 
@@ -70,7 +149,7 @@ class DLinks {
 	//finalize toroidal structure of columns
 	inline void finalize_cols() {
 		Node* n1;
-		for(int i=0; i<324; ++i) {
+		for(int i=0; i<ncols; ++i) {
 			n1 = cols[i];
 			n1->connect_after_v(n1+n1->count);
 		}
@@ -79,9 +158,9 @@ class DLinks {
 	//assign the column headers to their respective lists based on node count
 	inline void assign_column_headers() {
 		Node* n1;
-		for(int i=0; i<324; ++i) {
+		for(int i=0; i<ncols; ++i) {
 			n1 = cols[i];
-			if(n1->count > 9) { continue; }
+			if(n1->count > side) { continue; }
 			n1->insert_after_h<false>(counts+n1->count);
 		}
 	}
@@ -100,21 +179,16 @@ class DLinks {
 		return insert;
 	}
 
-	// return a column containing the minimum uncovered nodes
-	// Note: in fact, just pick the first uncovered column
+	// return a column containing the minimum uncovered nodes, picked by the Select policy
 	//if all columns are covered - return NULL
 	inline Node* select_min_column() {
-		for(int i=0; i<10; ++i) {
-			if(counts[i].right != &counts[i]) {
-				return counts[i].right;
-			}
-		}
-		return 0;
+		return Select::select(*this);
 	}
 
 	//cover a column of node n for dancing links algorithm
 	inline void cover(Node* n) {
 		Node* col_node = cols[n->col];
+		SEARCH_STAT(++stats.covers;)
 		//unlink left and right neighbors of col from col
 		col_node->disconnect<h>();
 		//iterate through each Node in col top to bottom
@@ -123,6 +197,7 @@ class DLinks {
 			//for each Node in this row, unlink top and bottom neighbors and reduce count of that column
 			for(Node* horiz_itr=vert_itr->right; horiz_itr!=vert_itr; horiz_itr=horiz_itr->right) {
 				horiz_itr->disconnect<v>();
+				SEARCH_STAT(++stats.nodes;)
 				Node* cn = cols[horiz_itr->col];
 				--cn->count;
 				//if column cn is not covered - push it into new list
@@ -136,6 +211,7 @@ class DLinks {
 	//uncover a column of node n for dancing links algorithm
 	inline void uncover(Node* n) {
 		Node* col_node = cols[n->col];
+		SEARCH_STAT(++stats.uncovers;)
 		//relink left and right neighbors of col to col
 		col_node->insert_after_h<false>(counts+col_node->count);
 
@@ -145,6 +221,7 @@ class DLinks {
 			//for each Node in this row, relink top and bottom neighbors and increment count of that column
 			for(Node* horiz_itr=vert_itr->left; horiz_itr!=vert_itr; horiz_itr=horiz_itr->left) {
 				horiz_itr->reconnect_v();
+				SEARCH_STAT(++stats.nodes;)
 				Node* cn = cols[horiz_itr->col];
 				++cn->count;
 				//if column cn is not covered - push it into new list
@@ -201,17 +278,28 @@ class DLinks {
 #endif
 
 	//iterative implementation of the search
-	inline bool alg_x_itr_search(int num_start_sols) {
+	//counts exact covers until limit solutions are found or the search space is exhausted,
+	//limit 2 is enough to tell whether a puzzle has a unique solution
+	//returns the number of solutions found, solution_stack holds the first of them
+	inline int alg_x_itr_search(int num_start_sols, int limit = 1) {
 		//select initial column to begin the search
 		Node* selected_col, *vert_itr, *horiz_itr;
-		if((selected_col = select_min_column())->count < 1) {
-			return false;
+		int found = 0;
+		branches = backtracks = 0;
+		SEARCH_STAT(stats.reset();)
+		if((selected_col = select_min_column()) == 0) {
+			return 1;
+		}
+		if(selected_col->count < 1) {
+			return 0;
 		}
 
 		vert_itr = selected_col->down;
 		while(true) {
 			//select current row as partial solution and cover
 			solution_stack[solution_ptr++] = vert_itr;
+			++branches;
+			SEARCH_STAT(stats.depth(solution_ptr - num_start_sols);)
 			horiz_itr = vert_itr;
 			do {
 				cover(horiz_itr);
@@ -219,17 +307,31 @@ class DLinks {
 
 			//select next column and check for solution, and branch failure
 			if((selected_col = select_min_column()) == 0) {
-				return true;
-			}
-			if(selected_col->count > 0) {
+				if(++found == limit) {
+					if(found > 1) {
+						memcpy(solution_stack, first_solution, sizeof(first_solution));
+					}
+					return found;
+				}
+				//keep the first solution and backtrack for the next one
+				if(found == 1) {
+					memcpy(first_solution, solution_stack, sizeof(first_solution));
+				}
+			} else if(selected_col->count > 0) {
 				vert_itr = selected_col->down;
 				continue;
 			}
 
 			//uncover last partial solution
 			do {
-				if(--solution_ptr < num_start_sols) { return false; }
+				if(--solution_ptr < num_start_sols) {
+					if(found > 0) {
+						memcpy(solution_stack, first_solution, sizeof(first_solution));
+					}
+					return found;
+				}
 				vert_itr  = solution_stack[solution_ptr];
+				++backtracks;
 				horiz_itr = vert_itr->left;
 				do{
 					uncover(horiz_itr);
@@ -240,9 +342,59 @@ class DLinks {
 		}
 	}
 
-	//cover the known solutions to the puzzle when initializing the matrix
-	void initial_cover(Node* c){
-		c->count = 100;
+	//link the 4 nodes of a row left to right
+	static inline void link_row(Node* n1, Node* n2, Node* n3, Node* n4) {
+		n1->right = n2; n2->right = n3; n3->right = n4; n4->right = n1;
+		n4->left = n3; n3->left = n2; n2->left = n1; n1->left = n4;
+	}
+
+	//the matrix of the empty grid: all nrows rows, side nodes in every column
+	//built once and shared read only, restore copies it into a solver for each puzzle
+	static const DancingLinks &empty_grid();
+
+	//node of the given row in the column of its cell
+	inline Node* row_node(int row) {
+		return &cols[row/side][1 + row%side];
+	}
+
+	//copy the empty grid matrix into this one, rebasing the links onto this copy
+	inline void restore() {
+		const DancingLinks &grid = empty_grid();
+		uintptr_t delta = (uintptr_t)this - (uintptr_t)&grid;
+		const Node *src = &grid.cols[0][0];
+		Node *dst = &cols[0][0];
+		for(int i=0; i<ncols*(side+1); ++i) {
+			rebase(dst[i], src[i], delta);
+		}
+		//the count lists are filled by assign_column_headers once the givens are out
+		for(int i=0; i<side+2; ++i) {
+			counts[i].selfloop_h();
+		}
+		solution_ptr = 0;
+	}
+
+	//take the row of node n into the initial solution and cover its columns
+	inline void place_row(Node* n) {
+		solution_stack[solution_ptr++] = n;
+		Node* horiz_itr = n;
+		do {
+			initial_cover(cols[horiz_itr->col]);
+		} while((horiz_itr = horiz_itr->right) != n);
+	}
+
+	//unlink the row of node n from its columns, as a conflicting row would
+	inline void remove_row(Node* n) {
+		Node* horiz_itr = n;
+		do {
+			horiz_itr->disconnect<v>();
+			--cols[horiz_itr->col]->count;
+		} while((horiz_itr = horiz_itr->right) != n);
+	}
+
+	//cover a column of the initial solution, the count lists are not maintained
+	//and the column is kept out of them by its count
+	inline void initial_cover(Node* c) {
+		c->count = 4*side;
 		for(Node* vert_itr=c->down; vert_itr!=c; vert_itr=vert_itr->down) {
 			for(Node* horiz_itr=vert_itr->right; horiz_itr!=vert_itr; horiz_itr=horiz_itr->right) {
 				horiz_itr->disconnect<v>();
@@ -250,71 +402,338 @@ class DLinks {
 			}
 		}
 	}
+
+	private:
+	static inline void rebase(Node &dst, const Node &src, uintptr_t delta) {
+		dst.row = src.row;
+		dst.col = src.col;
+		dst.count = src.count;
+		dst.up    = (Node*)((uintptr_t)src.up + delta);
+		dst.down  = (Node*)((uintptr_t)src.down + delta);
+		dst.left  = (Node*)((uintptr_t)src.left + delta);
+		dst.right = (Node*)((uintptr_t)src.right + delta);
+	}
 };
 
-// lookup tables for the 4 constraints of a 9x9 sudoku
-const int one_c[] = { 0,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1,1,2,2,2,2,2,2,2,2,2,3,3,3,3,3,3,3,3,3,4,4,4,4,4,4,4,4,4,5,5,5,5,5,5,5,5,5,6,6,6,6,6,6,6,6,6,7,7,7,7,7,7,7,7,7,8,8,8,8,8,8,8,8,8,9,9,9,9,9,9,9,9,9,10,10,10,10,10,10,10,10,10,11,11,11,11,11,11,11,11,11,12,12,12,12,12,12,12,12,12,13,13,13,13,13,13,13,13,13,14,14,14,14,14,14,14,14,14,15,15,15,15,15,15,15,15,15,16,16,16,16,16,16,16,16,16,17,17,17,17,17,17,17,17,17,18,18,18,18,18,18,18,18,18,19,19,19,19,19,19,19,19,19,20,20,20,20,20,20,20,20,20,21,21,21,21,21,21,21,21,21,22,22,22,22,22,22,22,22,22,23,23,23,23,23,23,23,23,23,24,24,24,24,24,24,24,24,24,25,25,25,25,25,25,25,25,25,26,26,26,26,26,26,26,26,26,27,27,27,27,27,27,27,27,27,28,28,28,28,28,28,28,28,28,29,29,29,29,29,29,29,29,29,30,30,30,30,30,30,30,30,30,31,31,31,31,31,31,31,31,31,32,32,32,32,32,32,32,32,32,33,33,33,33,33,33,33,33,33,34,34,34,34,34,34,34,34,34,35,35,35,35,35,35,35,35,35,36,36,36,36,36,36,36,36,36,37,37,37,37,37,37,37,37,37,38,38,38,38,38,38,38,38,38,39,39,39,39,39,39,39,39,39,40,40,40,40,40,40,40,40,40,41,41,41,41,41,41,41,41,41,42,42,42,42,42,42,42,42,42,43,43,43,43,43,43,43,43,43,44,44,44,44,44,44,44,44,44,45,45,45,45,45,45,45,45,45,46,46,46,46,46,46,46,46,46,47,47,47,47,47,47,47,47,47,48,48,48,48,48,48,48,48,48,49,49,49,49,49,49,49,49,49,50,50,50,50,50,50,50,50,50,51,51,51,51,51,51,51,51,51,52,52,52,52,52,52,52,52,52,53,53,53,53,53,53,53,53,53,54,54,54,54,54,54,54,54,54,55,55,55,55,55,55,55,55,55,56,56,56,56,56,56,56,56,56,57,57,57,57,57,57,57,57,57,58,58,58,58,58,58,58,58,58,59,59,59,59,59,59,59,59,59,60,60,60,60,60,60,60,60,60,61,61,61,61,61,61,61,61,61,62,62,62,62,62,62,62,62,62,63,63,63,63,63,63,63,63,63,64,64,64,64,64,64,64,64,64,65,65,65,65,65,65,65,65,65,66,66,66,66,66,66,66,66,66,67,67,67,67,67,67,67,67,67,68,68,68,68,68,68,68,68,68,69,69,69,69,69,69,69,69,69,70,70,70,70,70,70,70,70,70,71,71,71,71,71,71,71,71,71,72,72,72,72,72,72,72,72,72,73,73,73,73,73,73,73,73,73,74,74,74,74,74,74,74,74,74,75,75,75,75,75,75,75,75,75,76,76,76,76,76,76,76,76,76,77,77,77,77,77,77,77,77,77,78,78,78,78,78,78,78,78,78,79,79,79,79,79,79,79,79,79,80,80,80,80,80,80,80,80,80,};
-const int row_c[] = { 81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,81,82,83,84,85,86,87,88,89,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,90,91,92,93,94,95,96,97,98,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,99,100,101,102,103,104,105,106,107,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,108,109,110,111,112,113,114,115,116,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,117,118,119,120,121,122,123,124,125,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,126,127,128,129,130,131,132,133,134,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,135,136,137,138,139,140,141,142,143,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,144,145,146,147,148,149,150,151,152,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161,153,154,155,156,157,158,159,160,161};
-const int col_c[] = { 162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242,162,163,164,165,166,167,168,169,170,171,172,173,174,175,176,177,178,179,180,181,182,183,184,185,186,187,188,189,190,191,192,193,194,195,196,197,198,199,200,201,202,203,204,205,206,207,208,209,210,211,212,213,214,215,216,217,218,219,220,221,222,223,224,225,226,227,228,229,230,231,232,233,234,235,236,237,238,239,240,241,242};
-const int box_c[] = { 243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,243,244,245,246,247,248,249,250,251,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,252,253,254,255,256,257,258,259,260,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,261,262,263,264,265,266,267,268,269,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,270,271,272,273,274,275,276,277,278,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,279,280,281,282,283,284,285,286,287,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,288,289,290,291,292,293,294,295,296,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,297,298,299,300,301,302,303,304,305,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,306,307,308,309,310,311,312,313,314,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323,315,316,317,318,319,320,321,322,323};
+typedef DancingLinks<DLINKS_SELECT> DLinks;
 
-//convert char array representing puzzle into constraint matrix for algorithm x
-// mask_row and mask_col, if given, represent the set values in their row or col as a bit mask
-inline bool solve_puzzle(DLinks *dl, unsigned char* sudoku_list, unsigned short *mask_row, unsigned short *mask_col){
-	using Node = DLinks::Node;
+//Compact layout of the toroidally linked matrix, same algorithm as DLinks
+//Nodes are addressed by 16-bit indices instead of pointers: node k of column c is index
+//c*10+k (k=0 is the column header) and the 11 count list heads follow the columns, so
+//the column of a node is its index / 10 and need not be stored.
+//The links walked by cover and uncover (8 bytes per node) are kept apart from the counts
+//and from the row of each node, which is only read to write out the solution.
+//About 33 KB per solver against about 155 KB for DLinks, small enough for L1.
+class DLinksCompact {
+	public:
+	static const int box = 3;
+	static const int side = 9;
+	static const int ncells = 81;
+	static const int nrows = 729;
+	typedef unsigned short Mask;
+	typedef unsigned short Index;
+	class Links {
+		public:
+		Index up, down, left, right;
+	};
+	static const int ncols = 324;
+	static const int stride = 10;				// nodes per column, header included
+	static const Index heads = ncols*stride;	// index of the head of count list 0
+	static const Index none = 0xffff;
+
+	Links link[ncols*stride + 11];
+	short count[ncols];
+	Index row[ncols*stride];
+	const Index *rows;			// row of each node, row or the one of the empty grid
+	Index solution_stack[81];
+	Index first_solution[81];	// copy of solution_stack when counting past the first solution
+	int solution_ptr;
+	int resolved;	// empty cells resolved by the propagation stage of solve_puzzle
+	unsigned long branches;		// rows tried by the last search
+	unsigned long backtracks;	// rows taken back by the last search
+	SEARCH_STAT(SearchStats stats;)
+	static const int template_rows = 256;	// copy the empty grid above this many candidate rows
+
+	static inline int col_of(Index n) {
+		return n / stride;
+	}
+	static inline bool is_header(Index n) {
+		return n % stride == 0;
+	}
 
-	Node* init_covered[324];
-	int init_ptr = 0;
+	template<bool cut = true>
+	inline void insert_after_h(Index n, Index ante) {
+		if ( cut ) {
+			disconnect_h(n);
+		}
+		link[n].right = link[ante].right;
+		link[n].left  = ante;
+		link[link[ante].right].left = n;
+		link[ante].right = n;
+	}
+	inline void disconnect_h(Index n) {
+		link[link[n].right].left = link[n].left;
+		link[link[n].left].right = link[n].right;
+	}
+	inline void disconnect_v(Index n) {
+		link[link[n].down].up = link[n].up;
+		link[link[n].up].down = link[n].down;
+	}
+	// inverse operation to disconnect_v,
+	// provided the node preserved the prior up and down links
+	inline void reconnect_v(Index n) {
+		link[link[n].down].up = n;
+		link[link[n].up].down = n;
+	}
 
-	dl->init();
-	//iterate through sudoku list
-	int row = 0;
-	for(int i=0; i<81; ++i) {
-		Node *n1;
-		int single = 0;
-
-		// if no value assigned to cell, populate all rows representing all possible candidate values for cell
-		// except for those already set in the row or col
-		unsigned int cands = sudoku_list[i] == '0'? 0x1ff : sudoku_list[i] == '.'? 0x1ff : sudoku_list[i]-'0';
-		if( cands == 0x1ff) {	// i.e. all candidates as bitmask.
-			if ( mask_row ) {
-				cands &= ~mask_row[i/9];
+	inline void init() {
+		for(int i=0; i<ncols; ++i) {
+			count[i] = 0;
+		}
+		for(int i=0; i<11; ++i) {
+			link[heads+i].left = link[heads+i].right = heads+i;
+		}
+		solution_ptr = 0;
+	}
+
+	//finalize toroidal structure of columns
+	inline void finalize_cols() {
+		for(int i=0; i<ncols; ++i) {
+			Index c = i*stride, last = c+count[i];
+			link[last].down = c;
+			link[c].up = last;
+		}
+	}
+
+	//assign the column headers to their respective lists based on node count
+	inline void assign_column_headers() {
+		for(int i=0; i<ncols; ++i) {
+			if(count[i] > 9) { continue; }
+			insert_after_h<false>(i*stride, heads+count[i]);
+		}
+	}
+
+	//appends a node for row to column col, the up links are set as it goes
+	//returns the index of the node
+	inline Index insert(int r, int col) {
+		Index last = col*stride + count[col]++;
+		Index n = last+1;
+		row[n] = r;
+		link[last].down = n;
+		link[n].up = last;
+		return n;
+	}
+
+	// return the header of a column containing the minimum uncovered nodes
+	//if all columns are covered - return none
+	inline Index select_min_column() {
+		for(int i=0; i<10; ++i) {
+			if(link[heads+i].right != heads+i) {
+				return link[heads+i].right;
 			}
-			if ( mask_col ) {
-				cands &= ~mask_col[i%9];
+		}
+		return none;
+	}
+
+	//cover the column of node n for dancing links algorithm
+	inline void cover(Index n) {
+		Index c = col_of(n)*stride;
+		SEARCH_STAT(++stats.covers;)
+		disconnect_h(c);
+		for(Index v=link[c].down; v!=c; v=link[v].down) {
+			for(Index h=link[v].right; h!=v; h=link[h].right) {
+				disconnect_v(h);
+				SEARCH_STAT(++stats.nodes;)
+				int col = col_of(h);
+				Index cn = col*stride;
+				--count[col];
+				//if column cn is not covered - move it to its new list
+				if(link[link[cn].right].left == cn) {
+					insert_after_h(cn, heads+count[col]);
+				}
 			}
-		} else {
-			single = cands;
 		}
-		//for the bits in the given sudoku candidates, populate rows representing the possible candidates
-		if ( single == 0 ) {
-			for(unsigned int j=0; j<9; ++j) {
-				if ( (1<<j) & cands ) {
-					row = i*9+j;
-					if ( cands == (1U<<j) ) {
-						single = j+1;
-						break;
-					} else {
-						Node* n1 = dl->insert(row, one_c[row]);
-						Node* n2 = dl->insert(row, row_c[row]);
-						Node* n3 = dl->insert(row, col_c[row]);
-						Node* n4 = dl->insert(row, box_c[row]);
-						n1->right = n2; n2->right = n3; n3->right = n4; n4->right = n1;
-						n4->left = n3; n3->left = n2; n2->left = n1; n1->left = n4;
+	}
+
+	//uncover the column of node n for dancing links algorithm
+	inline void uncover(Index n) {
+		int col = col_of(n);
+		Index c = col*stride;
+		SEARCH_STAT(++stats.uncovers;)
+		insert_after_h<false>(c, heads+count[col]);
+		for(Index v=link[c].up; v!=c; v=link[v].up) {
+			for(Index h=link[v].left; h!=v; h=link[h].left) {
+				reconnect_v(h);
+				SEARCH_STAT(++stats.nodes;)
+				int hcol = col_of(h);
+				Index cn = hcol*stride;
+				++count[hcol];
+				if(link[link[cn].right].left == cn) {
+					insert_after_h(cn, heads+count[hcol]);
+				}
+			}
+		}
+	}
+
+	//iterative search, see DLinks::alg_x_itr_search
+	inline int alg_x_itr_search(int num_start_sols, int limit = 1) {
+		Index selected_col, vert_itr, horiz_itr;
+		int found = 0;
+		branches = backtracks = 0;
+		SEARCH_STAT(stats.reset();)
+		if((selected_col = select_min_column()) == none) {
+			return 1;
+		}
+		if(count[col_of(selected_col)] < 1) {
+			return 0;
+		}
+
+		vert_itr = link[selected_col].down;
+		while(true) {
+			//select current row as partial solution and cover
+			solution_stack[solution_ptr++] = vert_itr;
+			++branches;
+			SEARCH_STAT(stats.depth(solution_ptr - num_start_sols);)
+			horiz_itr = vert_itr;
+			do {
+				cover(horiz_itr);
+			} while((horiz_itr = link[horiz_itr].right) != vert_itr);
+
+			//select next column and check for solution, and branch failure
+			if((selected_col = select_min_column()) == none) {
+				if(++found == limit) {
+					if(found > 1) {
+						memcpy(solution_stack, first_solution, sizeof(first_solution));
+					}
+					return found;
+				}
+				if(found == 1) {
+					memcpy(first_solution, solution_stack, sizeof(first_solution));
+				}
+			} else if(count[col_of(selected_col)] > 0) {
+				vert_itr = link[selected_col].down;
+				continue;
+			}
+
+			//uncover last partial solution
+			do {
+				if(--solution_ptr < num_start_sols) {
+					if(found > 0) {
+						memcpy(solution_stack, first_solution, sizeof(first_solution));
 					}
+					return found;
 				}
+				vert_itr  = solution_stack[solution_ptr];
+				++backtracks;
+				horiz_itr = link[vert_itr].left;
+				do{
+					uncover(horiz_itr);
+				} while ( (horiz_itr = link[horiz_itr].left) != link[vert_itr].left );
+				vert_itr = link[vert_itr].down;
+				//if next node is a header, then continue to uncover
+			} while(is_header(vert_itr));
+		}
+	}
+
+	inline void link_row(Index n1, Index n2, Index n3, Index n4) {
+		link[n1].right = n2; link[n2].right = n3; link[n3].right = n4; link[n4].right = n1;
+		link[n4].left = n3; link[n3].left = n2; link[n2].left = n1; link[n1].left = n4;
+	}
+
+	//the matrix of the empty grid, see DLinks::empty_grid
+	//its rows are shared, the row of a node in the copy does not depend on the puzzle
+	static const DLinksCompact &empty_grid();
+
+	static inline Index row_node(int row) {
+		return (row/9)*stride + 1 + row%9;
+	}
+
+	//copy the links and counts of the empty grid matrix into this one
+	inline void restore() {
+		const DLinksCompact &grid = empty_grid();
+		memcpy(link, grid.link, sizeof(link));
+		memcpy(count, grid.count, sizeof(count));
+		rows = grid.row;
+		for(int i=0; i<11; ++i) {
+			link[heads+i].left = link[heads+i].right = heads+i;
+		}
+		solution_ptr = 0;
+	}
+
+	//take the row of node n into the initial solution and cover its columns
+	inline void place_row(Index n) {
+		solution_stack[solution_ptr++] = n;
+		Index h = n;
+		do {
+			initial_cover(col_of(h));
+		} while((h = link[h].right) != n);
+	}
+
+	//unlink the row of node n from its columns, as a conflicting row would
+	inline void remove_row(Index n) {
+		Index h = n;
+		do {
+			disconnect_v(h);
+			--count[col_of(h)];
+		} while((h = link[h].right) != n);
+	}
+
+	//cover a column of the initial solution, see DLinks::initial_cover
+	inline void initial_cover(int col) {
+		Index c = col*stride;
+		count[col] = 100;
+		for(Index v=link[c].down; v!=c; v=link[v].down) {
+			for(Index h=link[v].right; h!=v; h=link[h].right) {
+				disconnect_v(h);
+				--count[col_of(h)];
 			}
 		}
-		if ( single ) {
-			row = i*9+single-1;
+	}
+};
+
+//convert the candidates of each cell into a constraint matrix for algorithm x
+// cands holds the candidate digits of each cell as a bit mask,
+// cells with a single candidate become part of the initial solution
+//returns the number of solutions, counting stops at limit
+template<class Select, int B>
+inline int build_candidates(DancingLinks<Select, B> *dl, const typename DancingLinks<Select, B>::Mask *cands, int limit){
+	typedef DancingLinks<Select, B> DL;
+	using Node = typename DL::Node;
+	const CoverTables<B> &t = cover_tables<B>;
+
+	Node* init_covered[DL::ncols];
+	int init_ptr = 0;
+
+	dl->init();
+	//iterate through the cells
+	int row = 0;
+	for(int i=0; i<DL::ncells; ++i) {
+		Node *n1;
+		unsigned int cell = cands[i];
+
+		//for a cell with several candidates, populate the rows representing them
+		if ( cell & (cell-1) ) {
+			for(unsigned int j=0; j<DL::side; ++j) {
+				if ( (1U<<j) & cell ) {
+					row = i*DL::side+j;
+					Node* n1 = dl->insert(row, t.one[row]);
+					Node* n2 = dl->insert(row, t.row[row]);
+					Node* n3 = dl->insert(row, t.col[row]);
+					Node* n4 = dl->insert(row, t.box[row]);
+					n1->right = n2; n2->right = n3; n3->right = n4; n4->right = n1;
+					n4->left = n3; n3->left = n2; n2->left = n1; n1->left = n4;
+				}
+			}
+		} else {
+			row = i*DL::side+__builtin_ctz(cell);
 
 			// mark each of the 4 columns as part of the initial solution
-			init_covered[init_ptr++] = &dl->cols[one_c[row]][0];
-			init_covered[init_ptr++] = &dl->cols[row_c[row]][0];
-			init_covered[init_ptr++] = &dl->cols[col_c[row]][0];
-			init_covered[init_ptr++] = &dl->cols[box_c[row]][0];
+			init_covered[init_ptr++] = &dl->cols[t.one[row]][0];
+			init_covered[init_ptr++] = &dl->cols[t.row[row]][0];
+			init_covered[init_ptr++] = &dl->cols[t.col[row]][0];
+			init_covered[init_ptr++] = &dl->cols[t.box[row]][0];
 
-			Node *p = dl->cols[one_c[row]];
+			Node *p = dl->cols[t.one[row]];
 			n1 = &p[p->count+1];
 			n1->row = row;
 			dl->solution_stack[dl->solution_ptr++] = n1;
@@ -331,21 +750,259 @@ inline bool solve_puzzle(DLinks *dl, unsigned char* sudoku_list, unsigned short
 
 	dl->assign_column_headers();
 
-	return dl->alg_x_itr_search(dl->solution_ptr);
+	return dl->alg_x_itr_search(dl->solution_ptr, limit);
 	//return dl->alg_x_rec_search();
 }
 
-inline bool solve_puzzle(DLinks * dl, unsigned char * puzzle) {
-	unsigned short mask_row[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-	unsigned short mask_col[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+//convert the candidates of each cell into a compact constraint matrix for algorithm x
+//see build_candidates(DLinks*, const unsigned short*, int)
+inline int build_candidates(DLinksCompact *dl, const unsigned short *cands, int limit){
+	using Index = DLinksCompact::Index;
+	const CoverTables<3> &t = cover_tables<3>;
+
+	int init_covered[324];
+	int init_ptr = 0;
+
+	dl->init();
+	dl->rows = dl->row;
+	for(int i=0; i<81; ++i) {
+		unsigned int cell = cands[i];
+		if ( cell & (cell-1) ) {
+			for(unsigned int j=0; j<9; ++j) {
+				if ( (1<<j) & cell ) {
+					int row = i*9+j;
+					Index n1 = dl->insert(row, t.one[row]);
+					Index n2 = dl->insert(row, t.row[row]);
+					Index n3 = dl->insert(row, t.col[row]);
+					Index n4 = dl->insert(row, t.box[row]);
+					dl->link[n1].right = n2; dl->link[n2].right = n3; dl->link[n3].right = n4; dl->link[n4].right = n1;
+					dl->link[n4].left = n3; dl->link[n3].left = n2; dl->link[n2].left = n1; dl->link[n1].left = n4;
+				}
+			}
+		} else {
+			int row = i*9+__builtin_ctz(cell);
+
+			// mark each of the 4 columns as part of the initial solution
+			init_covered[init_ptr++] = t.one[row];
+			init_covered[init_ptr++] = t.row[row];
+			init_covered[init_ptr++] = t.col[row];
+			init_covered[init_ptr++] = t.box[row];
+
+			// the row is kept in a spare node of its cell column
+			Index n1 = t.one[row]*DLinksCompact::stride + dl->count[t.one[row]] + 1;
+			dl->row[n1] = row;
+			dl->solution_stack[dl->solution_ptr++] = n1;
+		}
+	}
+
+	dl->finalize_cols();
+	for(int i=0; i<init_ptr; ++i) {
+		dl->initial_cover(init_covered[i]);
+	}
+	dl->assign_column_headers();
+
+	return dl->alg_x_itr_search(dl->solution_ptr, limit);
+}
 
-    for(int i=0; i<81; ++i) {
-		if ( puzzle[i] == '0' ||  puzzle[i] == '.' ) {
+
+//build the empty grid matrix into dl, the rows in order so row r is node 1+r%side of cell column r/side
+template<class DL>
+inline void build_empty_grid(DL *dl) {
+	const CoverTables<DL::box> &t = cover_tables<DL::box>;
+	dl->init();
+	for(int row=0; row<DL::nrows; ++row) {
+		auto n1 = dl->insert(row, t.one[row]);
+		auto n2 = dl->insert(row, t.row[row]);
+		auto n3 = dl->insert(row, t.col[row]);
+		auto n4 = dl->insert(row, t.box[row]);
+		dl->link_row(n1, n2, n3, n4);
+	}
+	dl->finalize_cols();
+	dl->assign_column_headers();
+}
+
+template<class Select, int B>
+inline const DancingLinks<Select, B> &DancingLinks<Select, B>::empty_grid() {
+	static const DancingLinks *grid = [] {
+		DancingLinks *dl = new DancingLinks;
+		build_empty_grid(dl);
+		return dl;
+	}();
+	return *grid;
+}
+
+inline const DLinksCompact &DLinksCompact::empty_grid() {
+	static const DLinksCompact *grid = [] {
+		DLinksCompact *dl = new DLinksCompact;
+		build_empty_grid(dl);
+		return dl;
+	}();
+	return *grid;
+}
+
+//set up the constraint matrix for algorithm x from a copy of the empty grid matrix
+// cands holds the candidate digits of each cell as a bit mask,
+// cells with a single candidate become part of the initial solution
+//the rows of the excluded candidates are removed, then the columns of the singles covered
+//returns the number of solutions, counting stops at limit
+template<class DL>
+inline int restore_candidates(DL *dl, const typename DL::Mask *cands, int limit) {
+	const unsigned int all = (1U << DL::side) - 1;
+	dl->restore();
+	for(int i=0; i<DL::ncells; ++i) {
+		for(unsigned int out = ~cands[i] & all; out; out &= out-1) {
+			dl->remove_row(dl->row_node(i*DL::side+__builtin_ctz(out)));
+		}
+	}
+	for(int i=0; i<DL::ncells; ++i) {
+		unsigned int cell = cands[i];
+		if ( (cell & (cell-1)) == 0 ) {
+			dl->place_row(dl->row_node(i*DL::side+__builtin_ctz(cell)));
+		}
+	}
+	dl->assign_column_headers();
+	return dl->alg_x_itr_search(dl->solution_ptr, limit);
+}
+
+//search the constraint matrix of the candidates in cands
+//building the matrix costs about the rows kept, starting from the empty grid about the rows
+//removed, so the copy is only used for the candidates of lightly resolved puzzles
+template<class DL>
+inline int solve_candidates(DL *dl, const typename DL::Mask *cands, int limit) {
+	int rows = 0;
+	for(int i=0; i<DL::ncells; ++i) {
+		if ( cands[i] & (cands[i]-1) ) {
+			rows += __builtin_popcount(cands[i]);
+		}
+	}
+	if ( rows > DL::template_rows ) {
+		return restore_candidates(dl, cands, limit);
+	}
+	return build_candidates(dl, cands, limit);
+}
+
+template<class Select, int B>
+inline int solve_puzzle(DancingLinks<Select, B> *dl, const typename DancingLinks<Select, B>::Mask *cands, int limit = 1) {
+	return solve_candidates(dl, cands, limit);
+}
+
+inline int solve_puzzle(DLinksCompact *dl, const unsigned short *cands, int limit = 1) {
+	return solve_candidates(dl, cands, limit);
+}
+
+//apply naked and hidden singles, then search the matrix built from the remaining candidates
+template<class DL>
+inline int solve_propagated(DL *dl, const unsigned char *puzzle, int limit) {
+	BitBoard::State s;
+	unsigned char queue[81];
+
+	int givens = BitBoard::load(s, puzzle, queue);
+	dl->resolved = 0;
+	dl->branches = dl->backtracks = 0;
+	SEARCH_STAT(dl->stats.reset();)
+	if ( !BitBoard::propagate(s, queue, givens) ) {
+		return 0;
+	}
+	dl->resolved = BitBoard::placed_cells(s) - givens;
+	return solve_puzzle(dl, s.cands, limit);
+}
+
+//candidates of each cell of a puzzle on any grid size: a given keeps its digit and the
+//digit is taken from the candidates of its peers, which repeats for every cell left
+//with a single candidate (naked singles)
+//returns the number of cells placed, -1 if a cell runs out of candidates or holds a
+//symbol that is not a digit of the grid
+template<int B, class Mask>
+inline int load_singles(const unsigned char *puzzle, Mask *cands, int &givens) {
+	const CoverTables<B> &t = cover_tables<B>;
+	const int side = B*B, ncells = side*side;
+	const unsigned int all = (1U << side) - 1;
+	short queue[ncells];
+	int qlen = 0;
+	givens = 0;
+	for(int i=0; i<ncells; ++i) {
+		unsigned char c = puzzle[i];
+		if ( c == '0' || c == '.' ) {
+			cands[i] = all;
 			continue;
 		}
-		int single_bit = 1<<(puzzle[i] - '1');
-		mask_row[i/9] |= single_bit;
-		mask_col[i%9] |= single_bit;
+		int d = digit_of(c);
+		if ( d < 1 || d > side ) {
+			return -1;
+		}
+		cands[i] = 1U << (d-1);
+		queue[qlen++] = i;
+	}
+	givens = qlen;
+	for(int q=0; q<qlen; ++q) {
+		int i = queue[q];
+		Mask bit = cands[i];
+		for(int k=0; k<CoverTables<B>::npeers; ++k) {
+			Mask &m = cands[t.peers[i][k]];
+			if ( (m & bit) == 0 ) {
+				continue;
+			}
+			m &= ~bit;
+			if ( m == 0 ) {
+				return -1;
+			}
+			if ( (m & (m-1)) == 0 ) {
+				queue[qlen++] = t.peers[i][k];
+			}
+		}
+	}
+	return qlen;
+}
+
+//solve a puzzle of a larger grid: naked singles, then search the matrix of the remaining candidates
+template<class Select, int B>
+inline int solve_singles(DancingLinks<Select, B> *dl, const unsigned char *puzzle, int limit) {
+	typename DancingLinks<Select, B>::Mask cands[DancingLinks<Select, B>::ncells];
+	int givens;
+	int placed = load_singles<B>(puzzle, cands, givens);
+	dl->resolved = 0;
+	dl->branches = dl->backtracks = 0;
+	SEARCH_STAT(dl->stats.reset();)
+	if ( placed < 0 ) {
+		return 0;
 	}
-	return solve_puzzle(dl, puzzle, mask_row, mask_col);
-}
\ No newline at end of file
+	dl->resolved = placed - givens;
+	return solve_puzzle(dl, cands, limit);
+}
+
+//convert char array representing puzzle into constraint matrix for algorithm x
+//before building the matrix, naked and hidden singles over the row, column and box
+//masks are applied until nothing changes; the cells they resolve join the givens
+//as initial solution, so the search only walks the remaining candidates
+//the puzzle holds ncells symbols (see digit_of); the bitboard propagation is specific to
+//9x9 grids, larger ones only get naked singles
+//returns the number of solutions, counting stops at limit
+template<class Select, int B>
+inline int solve_puzzle(DancingLinks<Select, B> * dl, const unsigned char * puzzle, int limit = 1) {
+	if constexpr ( B == 3 ) {
+		return solve_propagated(dl, puzzle, limit);
+	} else {
+		return solve_singles(dl, puzzle, limit);
+	}
+}
+
+inline int solve_puzzle(DLinksCompact * dl, const unsigned char * puzzle, int limit = 1) {
+	return solve_propagated(dl, puzzle, limit);
+}
+
+//write the digits of the solution found by the last solve_puzzle call as ncells symbols
+template<class Select, int B>
+inline void write_solution(DancingLinks<Select, B> *dl, unsigned char* out) {
+	typedef DancingLinks<Select, B> DL;
+	for(int j=0; j<DL::ncells; j++) {
+		int row = dl->solution_stack[j]->row;
+		out[row / DL::side] = symbol_of(row % DL::side + 1);
+	}
+}
+
+inline void write_solution(DLinksCompact *dl, unsigned char* out) {
+	for(int j=0; j<81; j++) {
+		int row = dl->rows[dl->solution_stack[j]];
+		out[row / 9] = (row % 9) + '1';
+	}
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+#include "column_select.hpp"
+#include "search_stats.hpp"
+
+//Toroidally linked matrix for any exact cover problem, the DLinks design without the sudoku
+//The sizes are fixed at compile time:
+//  NCols    - number of columns
+//  MaxNodes - nodes (1s of the matrix) over all rows
+//  MaxCount - most rows a column may have, the number of count lists
+//  NPrimary - the first NPrimary columns must be covered exactly once, the others are
+//             secondary and covered at most once (the diagonals of N queens)
+//Rows are loaded with add_row as lists of columns, then search counts the exact covers
+//with the iterative search and the count lists of DLinks.
+//Select is the column selection policy, MostRecent or LeastRecent (see column_select.hpp).
+template<int NCols, int MaxNodes, int MaxCount, int NPrimary = NCols, class Select = MostRecent>
+class ExactCover {
+	public:
+	static const int ncols = NCols;
+	static const int nprimary = NPrimary;
+	static const int max_count = MaxCount;
+
+	typedef enum {
+		h,	// horizontal: left and right
+		v	// vertical: up and down
+	} HV;
+
+	class Node {
+		public:
+		int row, col, count;
+		Node *up, *down, *left, *right;
+
+		template<bool cut = true>
+		inline void insert_after_h(Node *ante) {
+			if ( cut ) {
+				this->right->left = this->left;
+				this->left->right = this->right;
+			}
+			this->right = ante->right;
+			this->left  = ante;
+			ante->right->left = this;
+			ante->right = this;
+		}
+		inline void selfloop_h() {
+			this->left = this->right = this;
+		}
+		template<HV hv>
+		inline void disconnect() {
+			if ( hv == h ) {
+				this->right->left = this->left;
+				this->left->right = this->right;
+			} else {
+				this->down->up = this->up;
+				this->up->down = this->down;
+			}
+		}
+		// inverse operation to disconnect<v>,
+		// provided the node preserved the prior up and down links
+		inline void reconnect_v() {
+			this->down->up = this;
+			this->up->down = this;
+		}
+	};
+
+	Node cols[NCols];			// column headers, count is the number of rows of the column
+	Node counts[MaxCount+2];	// uncovered primary columns by count
+	Node parked;				// left and right of the secondary headers, never linked back to them
+	Node nodes[MaxNodes];
+	int nnodes;
+	int nrows;
+	Node* solution_stack[NPrimary];
+	int solution[NPrimary];		// rows of the first exact cover found by search
+	int solution_size;
+	unsigned long branches;		// rows tried by the last search
+	unsigned long backtracks;	// rows taken back by the last search
+	SEARCH_STAT(SearchStats stats;)
+
+	ExactCover() {
+		clear();
+	}
+
+	//remove all rows
+	inline void clear() {
+		for(int i=0; i<NCols; ++i) {
+			Node *c = &cols[i];
+			c->row = -1;
+			c->col = i;
+			c->count = 0;
+			c->up = c->down = c;
+			c->left = c->right = &parked;
+		}
+		parked.selfloop_h();
+		for(int i=0; i<MaxCount+2; ++i) {
+			counts[i].selfloop_h();
+		}
+		for(int i=0; i<NPrimary; ++i) {
+			cols[i].template insert_after_h<false>(counts);
+		}
+		nnodes = nrows = 0;
+		solution_size = 0;
+	}
+
+	//append a row with a node in each of the n columns in cols, in increasing order
+	//returns the index of the row, -1 if the row does not fit: too many nodes,
+	//a column out of range or a column past MaxCount rows
+	inline int add_row(const int *cols, int n) {
+		if ( n < 1 || nnodes + n > MaxNodes ) {
+			return -1;
+		}
+		for(int k=0; k<n; ++k) {
+			if ( cols[k] < 0 || cols[k] >= NCols || this->cols[cols[k]].count >= MaxCount ) {
+				return -1;
+			}
+		}
+		Node *first = &nodes[nnodes];
+		for(int k=0; k<n; ++k) {
+			Node *c = &this->cols[cols[k]];
+			Node *n1 = &nodes[nnodes++];
+			n1->row = nrows;
+			n1->col = cols[k];
+			//append to the bottom of the column
+			n1->up = c->up;
+			n1->down = c;
+			c->up->down = n1;
+			c->up = n1;
+			if ( cols[k] < NPrimary ) {
+				c->insert_after_h(&counts[c->count+1]);
+			}
+			++c->count;
+			//append to the end of the row
+			n1->left = k ? n1-1 : n1;
+			n1->right = first;
+			n1->left->right = n1;
+			first->left = n1;
+		}
+		return nrows++;
+	}
+
+	//copy the matrix of src into this one, rebasing the links onto this copy
+	//(see DLinks::restore), so both can be searched independently
+	inline void copy_from(const ExactCover &src) {
+		uintptr_t delta = (uintptr_t)this - (uintptr_t)&src;
+		for(int i=0; i<NCols; ++i) {
+			rebase(cols[i], src.cols[i], delta);
+		}
+		for(int i=0; i<MaxCount+2; ++i) {
+			rebase(counts[i], src.counts[i], delta);
+		}
+		rebase(parked, src.parked, delta);
+		for(int i=0; i<src.nnodes; ++i) {
+			rebase(nodes[i], src.nodes[i], delta);
+		}
+		nnodes = src.nnodes;
+		nrows = src.nrows;
+		solution_size = 0;
+	}
+
+	// return a primary column containing the minimum uncovered nodes, picked by the Select policy
+	//if all primary columns are covered - return NULL
+	inline Node* select_min_column() {
+		return Select::select(*this);
+	}
+
+	//cover the column of node n
+	inline void cover(Node* n) {
+		Node* col_node = &cols[n->col];
+		SEARCH_STAT(++stats.covers;)
+		col_node->template disconnect<h>();
+		for(Node* vert_itr=col_node->down; vert_itr!=col_node; vert_itr=vert_itr->down) {
+			for(Node* horiz_itr=vert_itr->right; horiz_itr!=vert_itr; horiz_itr=horiz_itr->right) {
+				horiz_itr->template disconnect<v>();
+				SEARCH_STAT(++stats.nodes;)
+				Node* cn = &cols[horiz_itr->col];
+				--cn->count;
+				//if primary column cn is not covered - move it to its new list
+				//(covered and secondary headers are not linked back by their right node)
+				if(cn->right->left == cn) {
+					cn->insert_after_h(&counts[cn->count]);
+				}
+			}
+		}
+	}
+
+	//uncover the column of node n
+	inline void uncover(Node* n) {
+		Node* col_node = &cols[n->col];
+		SEARCH_STAT(++stats.uncovers;)
+		if(n->col < NPrimary) {
+			col_node->template insert_after_h<false>(&counts[col_node->count]);
+		}
+		for(Node* vert_itr=col_node->up; vert_itr!=col_node; vert_itr=vert_itr->up) {
+			for(Node* horiz_itr=vert_itr->left; horiz_itr!=vert_itr; horiz_itr=horiz_itr->left) {
+				horiz_itr->reconnect_v();
+				SEARCH_STAT(++stats.nodes;)
+				Node* cn = &cols[horiz_itr->col];
+				++cn->count;
+				if(cn->right->left == cn) {
+					cn->insert_after_h(&counts[cn->count]);
+				}
+			}
+		}
+	}
+
+	//iterative search, see DLinks::alg_x_itr_search
+	//counts exact covers until limit are found or the search space is exhausted, 0 for no limit
+	//solution holds the rows of the first one; the matrix is left as loaded, so it can be
+	//searched again
+	//returns the number of exact covers found
+	inline unsigned long search(unsigned long limit = 1) {
+		Node* selected_col, *vert_itr;
+		unsigned long found = 0;
+		int solution_ptr = 0;
+		branches = backtracks = 0;
+		solution_size = 0;
+		SEARCH_STAT(stats.reset();)
+		if((selected_col = select_min_column()) == 0) {
+			return 1;
+		}
+		if(selected_col->count < 1) {
+			return 0;
+		}
+
+		vert_itr = selected_col->down;
+		while(true) {
+			//select current row as partial solution and cover
+			solution_stack[solution_ptr++] = vert_itr;
+			++branches;
+			SEARCH_STAT(stats.depth(solution_ptr);)
+			cover_row(vert_itr);
+
+			//select next column and check for solution, and branch failure
+			if((selected_col = select_min_column()) == 0) {
+				if(++found == 1) {
+					for(int i=0; i<solution_ptr; ++i) {
+						solution[i] = solution_stack[i]->row;
+					}
+					solution_size = solution_ptr;
+				}
+				if(found == limit) {
+					unwind(solution_ptr);
+					return found;
+				}
+			} else if(selected_col->count > 0) {
+				vert_itr = selected_col->down;
+				continue;
+			}
+
+			//uncover last partial solution
+			do {
+				if(--solution_ptr < 0) {
+					return found;
+				}
+				vert_itr  = solution_stack[solution_ptr];
+				++backtracks;
+				uncover_row(vert_itr);
+				vert_itr = vert_itr->down;
+				//if next node is a header, then continue to uncover
+			} while(vert_itr == &cols[vert_itr->col]);
+		}
+	}
+
+	//cover the columns of the row of node n left to right, taking the row into a cover
+	inline void cover_row(Node* n) {
+		Node* horiz_itr = n;
+		do {
+			cover(horiz_itr);
+		} while((horiz_itr = horiz_itr->right) != n);
+	}
+
+	//uncover the columns of the row of node n, the inverse of cover_row
+	inline void uncover_row(Node* n) {
+		Node* horiz_itr = n->left;
+		do {
+			uncover(horiz_itr);
+		} while((horiz_itr = horiz_itr->left) != n->left);
+	}
+
+	private:
+	static inline void rebase(Node &dst, const Node &src, uintptr_t delta) {
+		dst.row = src.row;
+		dst.col = src.col;
+		dst.count = src.count;
+		dst.up    = (Node*)((uintptr_t)src.up + delta);
+		dst.down  = (Node*)((uintptr_t)src.down + delta);
+		dst.left  = (Node*)((uintptr_t)src.left + delta);
+		dst.right = (Node*)((uintptr_t)src.right + delta);
+	}
+
+	//take back the rows of the partial solution
+	inline void unwind(int solution_ptr) {
+		while(solution_ptr > 0) {
+			uncover_row(solution_stack[--solution_ptr]);
+		}
+	}
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "checkpoint.hpp"
+
+//Writer stage for fixed size output records
+//The workers fill a batch buffer per claimed range of records and submit it; a writer thread
+//collects the submitted batches in record order and writes each contiguous run with one
+//pwritev, so the workers never touch the file (no page faults on a shared mapping) and the
+//file only grows as far as the records written.
+//The records are split in slices, contiguous ranges each written in order at its own offset
+//(record i at base + i*record size), so the threads can work through slices of their own.
+//The number of batch buffers is bounded, a worker waits for a free one when the writer
+//falls behind; as a worker takes a buffer before it claims records, and claims the records
+//of a slice in order, the first unwritten batch of each slice never waits for a buffer.
+//With a Checkpoint, the progress of each slice is saved about every interval_ms and at the
+//end, after a sync of the output unless the durability is none.
+class OutputWriter {
+	public:
+	enum Durability { none, periodic, at_end };
+	typedef Checkpoint::Slice Slice;
+
+	//the records [0, n) in nslices slices of about the same size
+	static std::vector<Slice> split(size_t n, unsigned int nslices) {
+		std::vector<Slice> slices;
+		for ( unsigned int i=0; i<nslices; i++ ) {
+			size_t begin = n*i/nslices;
+			slices.push_back({ begin, begin, n*(i+1)/nslices });
+		}
+		return slices;
+	}
+
+	class Batch {
+		public:
+		size_t first = 0;		// index of the first record
+		size_t n = 0;			// number of records
+		int owner = -1;			// worker that last filled it, see get
+		std::vector<unsigned char> data;
+
+		//room for n records of size bytes
+		inline unsigned char *reserve(size_t n, size_t size) {
+			if ( data.size() < n*size ) {
+				data.resize(n*size);
+			}
+			this->n = n;
+			return data.data();
+		}
+	};
+
+	//write the records of slices, ordered by begin, each from its next record
+	OutputWriter(int fd, const char *fn, off_t base, size_t recsize, const std::vector<Slice> &slices,
+		unsigned int max_batches, Durability durability, unsigned int sync_ms)
+		: fd(fd), fn(fn), base(base), recsize(recsize), durability(durability), sync_ms(sync_ms),
+		  batches(max_batches), slices(slices), last_sync(std::chrono::steady_clock::now()) {
+		for ( auto &b : batches ) {
+			idle.push_back(&b);
+		}
+		writer = std::thread([this]{ run(); });
+	}
+
+	~OutputWriter() {
+		finish();
+	}
+
+	//a free batch buffer, waits while all are in use
+	//given the worker asking, a buffer it filled before is preferred, then an unused one, so
+	//the pages of a buffer stay with the thread (and memory node) that first touched them
+	Batch *get(int worker = -1) {
+		std::unique_lock<std::mutex> lock(mtx);
+		freed.wait(lock, [this]{ return !idle.empty(); });
+		size_t pick = idle.size()-1;
+		if ( worker >= 0 ) {
+			for ( size_t i=0; i<idle.size(); i++ ) {
+				if ( idle[i]->owner == worker ) {
+					pick = i;
+					break;
+				}
+				if ( idle[i]->owner == -1 ) {
+					pick = i;
+				}
+			}
+		}
+		Batch *b = idle[pick];
+		idle[pick] = idle.back();
+		idle.pop_back();
+		b->owner = worker;
+		return b;
+	}
+
+	//return a batch that was not filled
+	void release(Batch *b) {
+		std::lock_guard<std::mutex> lock(mtx);
+		idle.push_back(b);
+		freed.notify_one();
+	}
+
+	//queue a filled batch for writing
+	void submit(Batch *b) {
+		std::lock_guard<std::mutex> lock(mtx);
+		pending[b->first] = b;
+		if ( b->first == slice_of(b->first).next ) {
+			ready.notify_one();
+		}
+	}
+
+	//the slices as they are, the records before next of each are written
+	std::vector<Slice> progress() {
+		std::lock_guard<std::mutex> lock(mtx);
+		return slices;
+	}
+
+	//save the progress to checkpoint while writing, set before the first submit
+	void set_checkpoint(Checkpoint *c) {
+		checkpoint = c;
+	}
+
+	//write the remaining batches, sync if asked and stop the writer thread
+	void finish() {
+		if ( !writer.joinable() ) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			done = true;
+			ready.notify_one();
+		}
+		writer.join();
+		if ( !pending.empty() ) {
+			fprintf(stderr, "Error writing %s: %zu batches after a gap, the first at record %zu\n", fn,
+				pending.size(), pending.begin()->first);
+		}
+		if ( durability != none ) {
+			sync();
+		}
+		if ( checkpoint ) {
+			save_checkpoint(slices);
+		}
+	}
+
+	private:
+	int fd;
+	const char *fn;
+	off_t base;					// file offset of the first record
+	size_t recsize;
+	Durability durability;
+	unsigned int sync_ms;		// time between syncs with the periodic policy
+	std::vector<Batch> batches;
+	std::vector<Batch *> idle;
+	std::map<size_t, Batch *> pending;	// submitted batches by first record
+	std::vector<Slice> slices;	// next of each is its first record not written yet
+	size_t turn = 0;			// slice written last
+	bool done = false;
+	std::mutex mtx;
+	std::condition_variable ready, freed;
+	std::chrono::steady_clock::time_point last_sync;
+	Checkpoint *checkpoint = nullptr;
+	std::chrono::steady_clock::time_point last_checkpoint = std::chrono::steady_clock::now();
+	bool unsynced = false;		// records written since the last sync, on the writer thread
+	std::thread writer;
+
+	//the slice holding record i
+	Slice &slice_of(size_t i) {
+		auto it = std::upper_bound(slices.begin(), slices.end(), i, [](size_t i, const Slice &s){ return i < s.begin; });
+		return *(it - 1);
+	}
+
+	//a slice whose next record is submitted, or -1
+	//the search starts after the slice written last, so all slices get their turn
+	int writable() {
+		for ( size_t k=1; k<=slices.size(); k++ ) {
+			size_t i = (turn + k) % slices.size();
+			if ( slices[i].next < slices[i].end && pending.count(slices[i].next) ) {
+				turn = i;
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void run() {
+		std::vector<Batch *> chain;
+		std::vector<struct iovec> iov;
+		std::unique_lock<std::mutex> lock(mtx);
+		while ( true ) {
+			int i;
+			ready.wait(lock, [&]{ return (i = writable()) >= 0 || done; });
+			if ( i < 0 ) {
+				return;
+			}
+			// take the longest run of consecutive batches of the slice
+			Slice &slice = slices[i];
+			size_t at = slice.next;
+			chain.clear();
+			for ( auto it = pending.find(at); it != pending.end() && it->first == at && at < slice.end && chain.size() < IOV_MAX; ) {
+				chain.push_back(it->second);
+				at += it->second->n;
+				it = pending.erase(it);
+			}
+			off_t offset = base + (off_t)(slice.next*recsize);
+			lock.unlock();
+
+			iov.clear();
+			for ( Batch *b : chain ) {
+				iov.push_back({ b->data.data(), b->n*recsize });
+			}
+			write_all(iov, offset);
+			unsynced = true;
+			if ( durability == periodic && std::chrono::steady_clock::now() - last_sync >= std::chrono::milliseconds(sync_ms) ) {
+				sync();
+			}
+			// only this thread moves next, so it reads the slices without the lock
+			if ( checkpoint && std::chrono::steady_clock::now() - last_checkpoint >=
+				 std::chrono::milliseconds(Checkpoint::interval_ms) ) {
+				std::vector<Slice> written = slices;
+				written[i].next = at;
+				save_checkpoint(written);
+			}
+
+			lock.lock();
+			slice.next = at;
+			for ( Batch *b : chain ) {
+				idle.push_back(b);
+			}
+			freed.notify_all();
+		}
+	}
+
+	//pwritev all of iov at offset, continuing after short writes
+	void write_all(std::vector<struct iovec> &iov, off_t offset) {
+		struct iovec *v = iov.data();
+		int cnt = iov.size();
+		while ( cnt > 0 ) {
+			ssize_t w = pwritev(fd, v, cnt, offset);
+			if ( w == -1 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				fprintf(stderr, "Error writing %s: %s\n", fn, strerror(errno));
+				exit(0);
+			}
+			offset += w;
+			for ( ; cnt > 0 && (size_t)w >= v->iov_len; ++v, --cnt ) {
+				w -= v->iov_len;
+			}
+			if ( cnt > 0 ) {
+				v->iov_base = (char *)v->iov_base + w;
+				v->iov_len -= w;
+			}
+		}
+	}
+
+	//save that the records before next of each of written are in the file, syncing them first
+	//if they may not be
+	void save_checkpoint(const std::vector<Slice> &written) {
+		if ( durability != none && unsynced ) {
+			sync();
+		}
+		checkpoint->save(written);
+		last_checkpoint = std::chrono::steady_clock::now();
+	}
+
+	void sync() {
+		if ( fdatasync(fd) == -1 ) {
+			fprintf(stderr, "Error syncing %s: %s\n", fn, strerror(errno));
+		}
+		unsynced = false;
+		last_sync = std::chrono::steady_clock::now();
+	}
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+//Packed binary puzzle and solution files
+//A 16 byte header (little endian) is followed by records of 41 bytes: the 81 cells at
+//4 bits each, cell i in the low (even i) or high (odd i) nibble of byte i/2, 0 for an
+//empty cell and 1-9 for a digit. The spare high nibble of the last byte is 0 in puzzle
+//files; in solution files it holds the number of solutions found, 0 meaning that the
+//puzzle has no solution (the grid is then empty).
+class PackedHeader {
+	public:
+	enum Kind { puzzles = 0, solutions = 1 };
+	static const size_t size = 16;
+	static const size_t record_size = 41;
+	static const uint16_t current_version = 1;
+	static const uint64_t unknown_count = ~0ULL;	// count of a file written as a stream
+
+	unsigned char magic[4];
+	uint16_t version;
+	uint8_t kind;
+	uint8_t reserved;
+	uint64_t count;
+
+	PackedHeader(Kind kind = puzzles, uint64_t count = unknown_count)
+		: magic{ 'S', 'D', 'K', 'P' }, version(current_version), kind(kind), reserved(0), count(count) {}
+
+	//the header in its file layout, little endian whatever the host order
+	inline void write(unsigned char *out) const {
+		memcpy(out, magic, 4);
+		store_le(out+4, version, 2);
+		out[6] = kind;
+		out[7] = reserved;
+		store_le(out+8, count, 8);
+	}
+
+	//read the header at the start of in, returns false if in does not start with one
+	inline bool read(const unsigned char *in, size_t insize) {
+		if(insize < size || memcmp(in, "SDKP", 4) != 0) {
+			return false;
+		}
+		memcpy(magic, in, 4);
+		version = load_le(in+4, 2);
+		kind = in[6];
+		reserved = in[7];
+		count = load_le(in+8, 8);
+		return true;
+	}
+
+	private:
+	static inline void store_le(unsigned char *out, uint64_t v, int n) {
+		for(int i=0; i<n; ++i) {
+			out[i] = v >> 8*i;
+		}
+	}
+
+	static inline uint64_t load_le(const unsigned char *in, int n) {
+		uint64_t v = 0;
+		for(int i=0; i<n; ++i) {
+			v |= (uint64_t)in[i] << 8*i;
+		}
+		return v;
+	}
+};
+static_assert(sizeof(PackedHeader) == PackedHeader::size, "packed header layout");
+
+//pack 81 cells given as chars ('0' or '.' for empty) into a 41 byte record
+inline void pack_cells(const unsigned char *cells, unsigned char *out, unsigned int spare = 0) {
+	for(int i=0; i<40; ++i) {
+		unsigned int lo = cells[2*i] == '.' ? 0 : cells[2*i]-'0';
+		unsigned int hi = cells[2*i+1] == '.' ? 0 : cells[2*i+1]-'0';
+		out[i] = lo | hi<<4;
+	}
+	out[40] = (cells[80] == '.' ? 0 : cells[80]-'0') | spare<<4;
+}
+
+//unpack a 41 byte record into 81 cells as chars, '0' for empty
+//returns the spare nibble, or -1 if a cell holds a value above 9
+inline int unpack_cells(const unsigned char *in, unsigned char *cells) {
+	unsigned int bad = 0;
+	for(int i=0; i<40; ++i) {
+		unsigned int lo = in[i] & 0xf, hi = in[i] >> 4;
+		bad |= (lo > 9) | (hi > 9);
+		cells[2*i]   = '0' + lo;
+		cells[2*i+1] = '0' + hi;
+	}
+	bad |= (in[40] & 0xf) > 9;
+	cells[80] = '0' + (in[40] & 0xf);
+	return bad ? -1 : in[40] >> 4;
+}
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <vector>
+#include "exact_cover.hpp"
+
+//Parallel search of a single exact cover problem on an ExactCover matrix
+//The search tree is expanded to split_depth by the first worker; each partial cover at that
+//depth becomes a task, the rows taken so far as indices into the nodes of the matrix.
+//Every worker searches its tasks on its own copy of the matrix. Tasks go to the workers in
+//turn, a worker takes its newest task first and an idle worker steals the oldest task of
+//another. While a worker is idle, the busy ones also split off the untried rows of the
+//shallowest level of their search as new tasks, so the work keeps spreading to the end.
+//A worker without a task sleeps on a condition variable until a task is queued, the last
+//task is done or the search is cancelled.
+//search counts the covers up to limit (0 for all); once limit are found the workers stop,
+//so limit 1 finds a first cover and cancels the rest of the search.
+template<class EC>
+class ParallelCover {
+	typedef typename EC::Node Node;
+	typedef std::vector<int> Task;
+
+	class Worker {
+		public:
+		EC ec;
+		std::mutex lock;
+		std::deque<Task> tasks;
+		Node* stack[EC::nprimary];	// a node of each row of the partial cover
+		Node* stop[EC::nprimary+1];	// the rows of a level end at this node: the column header, or the first one split off
+		unsigned long branches;
+	};
+
+	std::vector<Worker*> workers;
+	std::atomic<unsigned long> found;
+	std::atomic<size_t> pending;	// tasks queued or being searched
+	std::atomic<unsigned int> idle;	// workers waiting for a task
+	std::atomic<size_t> queued;		// tasks in the deques of the workers
+	std::atomic<bool> cancel;
+	std::mutex park;				// guards the sleep of idle workers on wake
+	std::condition_variable wake;
+	unsigned long limit;
+	size_t next_worker;				// worker given the next task of the expansion
+
+	public:
+	unsigned int nthreads;
+	int split_depth;
+	int solution[EC::nprimary];	// rows of the first cover found
+	int solution_size;
+	unsigned long branches;		// rows tried by the last search, over all workers
+	unsigned long ntasks;		// tasks searched by the last search, the root one included
+
+	ParallelCover(unsigned int nthreads, int split_depth = 3) : nthreads(nthreads ? nthreads : 1),
+		split_depth(split_depth), solution_size(0), branches(0), ntasks(0) {
+		for(unsigned int i=0; i<this->nthreads; ++i) {
+			workers.push_back(new Worker);
+		}
+	}
+
+	~ParallelCover() {
+		for(Worker *w : workers) {
+			delete w;
+		}
+	}
+
+	//count the exact covers of ec with all threads, stopping after limit of them (0 for no limit)
+	//ec itself is only copied; solution holds the rows of the first cover found
+	//returns the number of covers found
+	inline unsigned long search(const EC &ec, unsigned long limit = 0) {
+		this->limit = limit;
+		found = 0;
+		pending = 1;
+		idle = 0;
+		queued = 0;
+		cancel = false;
+		next_worker = 0;
+		solution_size = 0;
+		ntasks = 0;
+		for(Worker *w : workers) {
+			w->ec.copy_from(ec);
+			w->tasks.clear();
+			w->branches = 0;
+		}
+
+		std::atomic<unsigned long> tasks_done(0);
+		std::vector<std::thread> threads;
+		for(unsigned int i=1; i<nthreads; ++i) {
+			threads.emplace_back([this, i, &tasks_done]{ tasks_done += thread_loop(i, false); });
+		}
+		//the calling thread expands the tree, then works like the others
+		tasks_done += thread_loop(0, true);
+		for(auto &t : threads) {
+			t.join();
+		}
+
+		branches = 0;
+		for(Worker *w : workers) {
+			branches += w->branches;
+		}
+		ntasks = tasks_done;
+		unsigned long n = found;
+		return limit && n > limit ? limit : n;
+	}
+
+	private:
+	//search tasks until all are done or the search is cancelled,
+	//after expanding the tree to split_depth if root is set
+	//returns the number of tasks searched
+	inline unsigned long thread_loop(unsigned int self, bool root) {
+		Worker &w = *workers[self];
+		unsigned long done = 0;
+		Task task;
+		if(root) {
+			run(w, task, split_depth);
+			++done;
+			finished();
+		}
+		while(!cancel.load(std::memory_order_relaxed)) {
+			if(!take(self, task)) {
+				std::unique_lock<std::mutex> lock(park);
+				if(pending.load() == 0) {
+					break;
+				}
+				++idle;
+				wake.wait(lock, [this]{ return queued.load() > 0 || pending.load() == 0 || cancel.load(); });
+				--idle;
+				continue;
+			}
+			run(w, task, 0);
+			++done;
+			finished();
+		}
+		return done;
+	}
+
+	//wake the sleeping workers, all of them or one for a new task
+	//taking the lock orders the wakeup after the check of a worker about to sleep, so none is missed
+	inline void notify(bool all) {
+		{
+			std::lock_guard<std::mutex> guard(park);
+		}
+		if(all) {
+			wake.notify_all();
+		} else {
+			wake.notify_one();
+		}
+	}
+
+	//a task is done, once none is left the sleeping workers return
+	inline void finished() {
+		if(--pending == 0) {
+			notify(true);
+		}
+	}
+
+	//pop the newest task of worker self, or steal the oldest one of another worker
+	inline bool take(unsigned int self, Task &task) {
+		Worker &w = *workers[self];
+		{
+			std::lock_guard<std::mutex> guard(w.lock);
+			if(!w.tasks.empty()) {
+				task = std::move(w.tasks.back());
+				w.tasks.pop_back();
+				--queued;
+				return true;
+			}
+		}
+		for(unsigned int i=1; i<nthreads; ++i) {
+			Worker &victim = *workers[(self+i) % nthreads];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if(!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				--queued;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//queue the partial cover of the first depth rows of w's stack, followed by the row of node n
+	inline void push(Worker &w, int depth, Node* n, Worker &to) {
+		Task task(depth+1);
+		for(int i=0; i<depth; ++i) {
+			task[i] = w.stack[i] - w.ec.nodes;
+		}
+		task[depth] = n - w.ec.nodes;
+		++pending;
+		{
+			std::lock_guard<std::mutex> guard(to.lock);
+			to.tasks.push_back(std::move(task));
+			++queued;
+		}
+		if(idle.load() > 0) {
+			notify(false);
+		}
+	}
+
+	//a cover is complete: count it, keep it if it is the first, cancel once limit are found
+	inline void report(Worker &w, int depth) {
+		unsigned long n = ++found;
+		if(n == 1) {
+			for(int i=0; i<depth; ++i) {
+				solution[i] = w.stack[i]->row;
+			}
+			solution_size = depth;
+		}
+		if(limit && n >= limit) {
+			cancel = true;
+			notify(true);
+		}
+	}
+
+	//search the subtree of task on the matrix of w, the iterative search of ExactCover
+	//with split > 0 the partial covers of split rows are queued as tasks instead
+	inline void run(Worker &w, const Task &task, int split) {
+		EC &ec = w.ec;
+		int depth = 0;
+		for(int idx : task) {
+			w.stack[depth] = &ec.nodes[idx];
+			ec.cover_row(w.stack[depth++]);
+		}
+		const int base = depth;
+		Node* selected_col = ec.select_min_column();
+		if(selected_col == 0) {
+			report(w, depth);
+		} else if(selected_col->count > 0) {
+			w.stop[depth] = selected_col;
+			Node* vert_itr = selected_col->down;
+			while(!cancel.load(std::memory_order_relaxed)) {
+				if(split && depth == split-1) {
+					//the expansion: hand out the row as a task instead of searching it
+					push(w, depth, vert_itr, *workers[next_worker++ % nthreads]);
+				} else {
+					w.stack[depth++] = vert_itr;
+					++w.branches;
+					ec.cover_row(vert_itr);
+					if(!split && idle.load(std::memory_order_relaxed) > 0) {
+						split_off(w, base, depth);
+					}
+					if((selected_col = ec.select_min_column()) == 0) {
+						report(w, depth);
+					} else if(selected_col->count > 0) {
+						w.stop[depth] = selected_col;
+						vert_itr = selected_col->down;
+						continue;
+					}
+					--depth;
+					ec.uncover_row(vert_itr);
+				}
+				//next row of the level, or back up to a level that has one
+				vert_itr = vert_itr->down;
+				while(vert_itr == w.stop[depth]) {
+					if(--depth < base) {
+						break;
+					}
+					vert_itr = w.stack[depth];
+					ec.uncover_row(vert_itr);
+					vert_itr = vert_itr->down;
+				}
+				if(depth < base) {
+					break;
+				}
+			}
+		}
+		//take back what is still covered, after a cancel or the rows of the task
+		if(depth < base) {
+			depth = base;
+		}
+		while(depth > 0) {
+			ec.uncover_row(w.stack[--depth]);
+		}
+	}
+
+	//queue the untried rows of the shallowest level of w that has any, for idle workers,
+	//unless w still has queued tasks of its own
+	inline void split_off(Worker &w, int base, int depth) {
+		{
+			std::lock_guard<std::mutex> guard(w.lock);
+			if(!w.tasks.empty()) {
+				return;
+			}
+		}
+		for(int k=base; k<depth; ++k) {
+			Node* n = w.stack[k]->down;
+			if(n == w.stop[k]) {
+				continue;
+			}
+			for(; n != w.stop[k]; n = n->down) {
+				push(w, k, n, w);
+			}
+			w.stop[k] = w.stack[k]->down;
+			return;
+		}
+	}
+};
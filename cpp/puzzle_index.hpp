@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//Indexer of the puzzle records in a text buffer, one pass per buffer
+//A record is a line of 81 cells, each '1'-'9' or '0' / '.' for an empty cell,
+//terminated by LF or CRLF (the last line of the input may lack it).
+//Blank lines and lines starting with '#' are skipped, any other line is
+//rejected with an error naming its line number.
+class PuzzleIndex {
+	public:
+	size_t lines = 0;				// lines scanned so far, continues across buffers
+	size_t rejected = 0;			// lines rejected so far
+	const char *fn;					// input name for the error messages
+
+	PuzzleIndex(const char *fn) : fn(fn) {}
+
+	//scan buf[pos,size) and append the offsets of its valid records to offsets
+	//only complete lines are consumed, unless final is set and the input ends without NL
+	//returns the position after the last line consumed
+	size_t scan(const unsigned char *buf, size_t pos, size_t size, bool final, std::vector<size_t> &offsets) {
+		size_t start = pos, i = pos;
+#ifdef __SSE2__
+		const __m128i nl = _mm_set1_epi8('\n');
+		for(; i+16 <= size; i += 16) {
+			unsigned int m = _mm_movemask_epi8(_mm_cmpeq_epi8(
+				_mm_loadu_si128((const __m128i *)(buf+i)), nl));
+			for(; m; m &= m-1) {
+				size_t end = i + __builtin_ctz(m);
+				add_line(buf, start, end, offsets);
+				start = end+1;
+			}
+		}
+#endif
+		for(; i < size; ++i) {
+			if(buf[i] == '\n') {
+				add_line(buf, start, i, offsets);
+				start = i+1;
+			}
+		}
+		if(final && start < size) {
+			add_line(buf, start, size, offsets);
+			start = size;
+		}
+		return start;
+	}
+
+	private:
+	//true if all 81 chars at p are digits or '.'
+	static inline bool valid_cells(const unsigned char *p) {
+#ifdef __SSE2__
+		const __m128i zero = _mm_set1_epi8('0');
+		const __m128i bias = _mm_set1_epi8((char)0x80);
+		const __m128i ten  = _mm_set1_epi8((char)(0x80+10));
+		const __m128i dot  = _mm_set1_epi8('.');
+		unsigned int bad = 0;
+		// 5 blocks of 16 cover cells 0-79, an overlapping block ends at cell 80
+		static const int at[6] = { 0, 16, 32, 48, 64, 65 };
+		for(int b=0; b<6; ++b) {
+			__m128i c = _mm_loadu_si128((const __m128i *)(p+at[b]));
+			// c-'0' < 10 as an unsigned compare, via the signed compare of the biased values
+			__m128i digit = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(c, zero), bias), ten);
+			__m128i ok = _mm_or_si128(digit, _mm_cmpeq_epi8(c, dot));
+			bad |= _mm_movemask_epi8(ok) ^ 0xffff;
+		}
+		return bad == 0;
+#else
+		for(int i=0; i<81; ++i) {
+			if((p[i] < '0' || p[i] > '9') && p[i] != '.') {
+				return false;
+			}
+		}
+		return true;
+#endif
+	}
+
+	inline void add_line(const unsigned char *buf, size_t start, size_t end, std::vector<size_t> &offsets) {
+		++lines;
+		if(end > start && buf[end-1] == '\r') {
+			--end;
+		}
+		size_t len = end-start;
+		if(len == 81 && valid_cells(buf+start)) {
+			offsets.push_back(start);
+			return;
+		}
+		if(len == 0 || buf[start] == '#') {
+			return;
+		}
+		++rejected;
+		if(len != 81) {
+			fprintf(stderr, "%s:%zu: expected 81 cells, found %zu characters\n", fn, lines, len);
+		} else {
+			size_t k = 0;
+			while(('0' <= buf[start+k] && buf[start+k] <= '9') || buf[start+k] == '.') {
+				++k;
+			}
+			fprintf(stderr, "%s:%zu: invalid cell '%c' at column %zu\n", fn, lines, buf[start+k], k+1);
+		}
+	}
+};
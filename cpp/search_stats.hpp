@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+
+//Optional per puzzle search counters, compiled in with -DSEARCH_STATS (make STATS=1)
+//SEARCH_STAT(x) expands to x only then, so a normal build keeps the hot loops as they are.
+#ifdef SEARCH_STATS
+#define SEARCH_STAT(x) x
+#else
+#define SEARCH_STAT(x)
+#endif
+
+//counters of the last search of an engine
+class SearchStats {
+	public:
+	unsigned long covers;		// cover calls
+	unsigned long uncovers;		// uncover calls
+	unsigned long nodes;		// nodes unlinked or relinked by them
+	unsigned int max_depth;		// deepest search: rows chosen past the givens and propagated cells, levels for bitboard
+
+	inline void reset() {
+		covers = uncovers = nodes = 0;
+		max_depth = 0;
+	}
+	inline void depth(unsigned int d) {
+		if(d > max_depth) {
+			max_depth = d;
+		}
+	}
+};
+
+//counters of one solved puzzle
+class PuzzleStats {
+	public:
+	SearchStats search;
+	unsigned long branches;
+	unsigned long backtracks;
+	unsigned long ns;			// wall time of the solve
+	int nsols;
+};
+
+//Writes the counters of each puzzle, numbered by its place in the input, as CSV to a sidecar
+//of the output file (<output>.stats.csv, stats.csv for stdout) and keeps a histogram of the
+//solve times, printed by finish.
+//A resumed run appends to the sidecar of the run it continues, so the rows of the puzzles
+//solved after the last checkpoint of that run appear twice.
+class StatsSidecar {
+	FILE *f;
+	std::string fn;
+	size_t n = 0;					// number of the last puzzle written
+	unsigned long hist[40] = {};	// puzzles by solve time, bucket b for [2^b, 2^(b+1)) ns
+	unsigned long total_ns = 0;
+
+	public:
+	//append: add to the sidecar of an earlier run instead of starting a new one
+	StatsSidecar(const char *ofn, bool append = false) : fn(strcmp(ofn, "-") == 0 ? "stats.csv" : std::string(ofn) + ".stats.csv") {
+		f = fopen(fn.c_str(), append ? "a" : "w");
+		if ( f == NULL ) {
+			fprintf(stderr, "Error opening stats file %s: %s\n", fn.c_str(), strerror(errno));
+			return;
+		}
+		fseek(f, 0, SEEK_END);
+		if ( ftell(f) == 0 ) {
+			fprintf(f, "puzzle,solutions,covers,uncovers,nodes,max_depth,branches,backtracks,ns\n");
+		}
+	}
+
+	//append the counters of the next count puzzles
+	void add(const PuzzleStats *stats, size_t count) {
+		add(stats, count, n);
+	}
+
+	//append the counters of count puzzles, the first of them the one after puzzle number first
+	void add(const PuzzleStats *stats, size_t count, size_t first) {
+		n = first;
+		for ( size_t i=0; i<count; i++ ) {
+			const PuzzleStats &s = stats[i];
+			if ( f ) {
+				fprintf(f, "%zu,%d,%lu,%lu,%lu,%u,%lu,%lu,%lu\n", ++n, s.nsols, s.search.covers,
+					s.search.uncovers, s.search.nodes, s.search.max_depth, s.branches, s.backtracks, s.ns);
+			}
+			int b = s.ns ? 63 - __builtin_clzl(s.ns) : 0;
+			hist[b < 40 ? b : 39]++;
+			total_ns += s.ns;
+		}
+	}
+
+	//close the sidecar and print the histogram of the solve times to stderr
+	void finish() {
+		if ( f ) {
+			fclose(f);
+			f = NULL;
+			fprintf(stderr, "per puzzle counters written to %s\n", fn.c_str());
+		}
+		unsigned long count = 0, most = 0;
+		for ( unsigned long h : hist ) {
+			count += h;
+			most = h > most ? h : most;
+		}
+		if ( count == 0 ) {
+			return;
+		}
+		fprintf(stderr, "solve time per puzzle, %.0fns on average:\n", (double)total_ns / count);
+		for ( int b=0; b<40; b++ ) {
+			if ( hist[b] == 0 ) {
+				continue;
+			}
+			int bar = (int)(50 * hist[b] / most);
+			fprintf(stderr, "  >= %9luns %8lu %5.1f%% %.*s\n", 1UL << b, hist[b], 100.0 * hist[b] / count,
+				bar > 0 ? bar : 1, "##################################################");
+		}
+	}
+};
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <mutex>
+#include "packed_format.hpp"
+
+//Cache of solutions shared by equivalent puzzles
+//Relabeling the digits, permuting the bands or the stacks and transposing the grid turn a
+//puzzle into an equivalent one, whose solutions are those of the original transformed the
+//same way. CanonicalPuzzle picks one grid out of each such class; SolutionCache keeps the
+//solutions of canonical grids, so a repeated puzzle or any transformation of it is solved once.
+
+//cell maps of the 72 band and stack permutations, each with and without transposition:
+//cell i of grid t is cell map[t][i] of the original, t = transpose*36 + band perm*6 + stack perm
+struct SymmetryMaps {
+	static const int count = 72;
+	static constexpr int perms[6][3] = { {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0} };
+	unsigned char map[count][81];
+	uint16_t stack_perm[6][512];	// the 9 cells of a row as bits, column 0 in bit 8, after each stack permutation
+
+	constexpr SymmetryMaps() : map(), stack_perm() {
+		for(int s=0; s<6; ++s) {
+			for(int v=0; v<512; ++v) {
+				for(int k=0; k<3; ++k) {
+					stack_perm[s][v] |= (v >> (6-3*perms[s][k]) & 7) << (6-3*k);
+				}
+			}
+		}
+		for(int t=0; t<count; ++t) {
+			const int *bands = perms[t/6%6], *stacks = perms[t%6];
+			for(int i=0; i<81; ++i) {
+				int r = bands[i/27]*3 + i/9%3, c = stacks[i%9/3]*3 + i%3;
+				map[t][i] = t/36 ? c*9+r : r*9+c;
+			}
+		}
+	}
+};
+constexpr SymmetryMaps symmetry_maps{};
+
+//canonical form of a puzzle: the smallest grid over all 72 cell maps, compared first by the
+//pattern of given cells (cell by cell, empty before given), then by the digits cell by cell
+//with the digits of each grid numbered in order of first appearance
+//the patterns are compared as bit masks, the digits only for the maps that tie on the
+//smallest pattern
+class CanonicalPuzzle {
+	public:
+	unsigned char cells[81];	// the canonical grid as chars, '0' for empty
+	const unsigned char *map;	// cell i of the canonical grid is cell map[i] of the puzzle
+	unsigned char label[10];	// digit d of the puzzle is digit label[d] of the canonical grid
+	unsigned char digit[10];	// the inverse of label
+
+	//puzzle holds 81 cells as chars, '0' or '.' for empty
+	CanonicalPuzzle(const unsigned char *puzzle) {
+		unsigned char in[81];
+		uint16_t rows[2][9] = {};	// given cells of the rows of the grid and of its transpose, column 0 in bit 8
+		for ( int r=0; r<9; r++ ) {
+			for ( int c=0; c<9; c++ ) {
+				unsigned char d = puzzle[r*9+c] >= '1' && puzzle[r*9+c] <= '9' ? puzzle[r*9+c]-'0' : 0;
+				in[r*9+c] = d;
+				rows[0][r] |= (d != 0) << (8-c);
+				rows[1][c] |= (d != 0) << (8-r);
+			}
+		}
+		// the given cells of each band of the grid and of its transpose after each stack
+		// permutation, 27 bits with the first cell highest
+		uint32_t bands[2][6][3];
+		for ( int tr=0; tr<2; tr++ ) {
+			for ( int s=0; s<6; s++ ) {
+				const uint16_t *perm = symmetry_maps.stack_perm[s];
+				for ( int b=0; b<3; b++ ) {
+					const uint16_t *r = rows[tr]+3*b;
+					bands[tr][s][b] = (uint32_t)perm[r[0]] << 18 | perm[r[1]] << 9 | perm[r[2]];
+				}
+			}
+		}
+
+		// the maps with the smallest pattern, the first two bands and the last one compared as numbers
+		int ties[SymmetryMaps::count], nties = 0;
+		uint64_t best_hi = ~0ULL;
+		uint32_t best_lo = ~0U;
+		for ( int t=0; t<SymmetryMaps::count; t++ ) {
+			const int *order = SymmetryMaps::perms[t/6%6];
+			const uint32_t *band = bands[t/36][t%6];
+			uint64_t hi = (uint64_t)band[order[0]] << 27 | band[order[1]];
+			uint32_t lo = band[order[2]];
+			if ( hi > best_hi || (hi == best_hi && lo > best_lo) ) {
+				continue;
+			}
+			if ( hi != best_hi || lo != best_lo ) {
+				best_hi = hi;
+				best_lo = lo;
+				nties = 0;
+			}
+			ties[nties++] = t;
+		}
+
+		map = nullptr;
+		for ( int k=0; k<nties; k++ ) {
+			const unsigned char *m = symmetry_maps.map[ties[k]];
+			unsigned char lab[10] = {};
+			int next = 0;
+			// the first grid is taken as it is, the others once they fall below the best one
+			bool less = map == nullptr;
+			for ( int i=0; i<81; i++ ) {
+				int d = in[m[i]];
+				if ( d && !lab[d] ) {
+					lab[d] = ++next;
+				}
+				unsigned char v = '0' + lab[d];
+				if ( !less ) {
+					if ( v > cells[i] ) {
+						break;
+					}
+					less = v < cells[i];
+				}
+				if ( less ) {
+					cells[i] = v;
+				}
+			}
+			if ( less ) {
+				map = m;
+				memcpy(label, lab, sizeof(label));
+			}
+		}
+		// digits missing from the puzzle take the free labels, so label is a permutation
+		int next = 0;
+		for ( int d=1; d<=9; d++ ) {
+			next += label[d] != 0;
+		}
+		for ( int d=1; d<=9; d++ ) {
+			if ( !label[d] ) {
+				label[d] = ++next;
+			}
+			digit[label[d]] = d;
+		}
+	}
+
+	//solution of the canonical grid to the solution of the puzzle, both 81 digits as chars
+	inline void to_puzzle(const unsigned char *canon, unsigned char *out) const {
+		for ( int i=0; i<81; i++ ) {
+			out[map[i]] = '0' + digit[canon[i]-'0'];
+		}
+	}
+
+	//solution of the puzzle to the solution of the canonical grid
+	inline void to_canonical(const unsigned char *solution, unsigned char *out) const {
+		for ( int i=0; i<81; i++ ) {
+			out[i] = '0' + label[solution[map[i]]-'0'];
+		}
+	}
+};
+
+//Set associative table of canonical puzzles and their solutions
+//An entry holds the canonical grid and its first solution as packed records (see
+//packed_format.hpp), the solution record with the number of solutions found up to the count
+//limit of the solve that stored it. Entries are kept in sets of ways, a new one takes a free
+//way of its set or replaces one picked by its hash. Each set is guarded by one of a few
+//striped locks, so the threads of a context share the cache.
+//The table is anonymous memory, or a shared mapping of a file that keeps it across runs;
+//entries carry a checksum, so one left half written by an interrupted run is just a miss.
+//Nothing is printed, a file that cannot be used is reported in error.
+class SolutionCache {
+	public:
+	static const size_t default_entries = 1<<20;
+	static const unsigned int ways = 4;
+
+	class Entry {
+		public:
+		unsigned char key[PackedHeader::record_size];		// the canonical grid
+		unsigned char solution[PackedHeader::record_size];	// its first solution and the count
+		uint8_t limit;										// the count limit of the solve
+		uint8_t reserved;
+		uint32_t check;										// fnv-1a of the bytes before
+
+		inline uint32_t checksum() const {
+			uint32_t h = 2166136261u;
+			const unsigned char *p = (const unsigned char *)this;
+			for ( size_t i=0; i<offsetof(Entry, check); i++ ) {
+				h = (h ^ p[i]) * 16777619u;
+			}
+			return h;
+		}
+	};
+
+	//a table of at least entries entries; with fn, the one kept in that file, created if it
+	//does not exist yet, an existing file keeps the size it was created with
+	//if fn cannot be used, the cache is kept in memory for this run only and error says why
+	SolutionCache(size_t entries, const char *fn = nullptr) {
+		nsets = 1;
+		while ( nsets*ways < entries ) {
+			nsets <<= 1;
+		}
+		if ( fn && !open_file(fn) ) {
+			size_t len = strlen(error);
+			snprintf(error+len, sizeof(error)-len, ", keeping the solution cache in memory");
+		}
+		if ( !table ) {
+			mapped = nsets*ways*sizeof(Entry);
+			void *p = mmap(nullptr, mapped, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+			if ( p != MAP_FAILED ) {
+				base = p;
+				table = (Entry *)p;
+			} else {
+				snprintf(error, sizeof(error), "No memory for a solution cache of %zu entries", nsets*ways);
+				nsets = 0;
+			}
+		}
+	}
+
+	~SolutionCache() {
+		if ( table ) {
+			munmap(base, mapped);
+		}
+		if ( fd != -1 ) {
+			close(fd);
+		}
+	}
+
+	SolutionCache(const SolutionCache &) = delete;
+	SolutionCache &operator=(const SolutionCache &) = delete;
+
+	inline size_t size() const { return nsets*ways; }
+
+	char error[512] = "";		// why the cache file or memory could not be used, empty if it could
+
+	//look up the canonical grid of c for a count of solutions up to limit
+	//returns the number of solutions (0 to limit) with the first one in solution (canonical
+	//digits as chars), or -1 if the grid is not cached or was counted to a lower limit only
+	inline int find(const CanonicalPuzzle &c, int limit, unsigned char *solution) {
+		unsigned char key[PackedHeader::record_size];
+		pack_cells(c.cells, key);
+		uint64_t h = hash(key);
+		Entry e;
+		if ( !lookup(h, key, e) ) {
+			return -1;
+		}
+		int nsols = unpack_cells(e.solution, solution);
+		if ( nsols < 0 || (nsols >= e.limit && e.limit < limit) ) {
+			return -1;
+		}
+		return nsols < limit ? nsols : limit;
+	}
+
+	//store the first solution (canonical digits as chars) and the count of solutions up to
+	//limit of the canonical grid of c, unless it is cached with a higher limit already
+	inline void add(const CanonicalPuzzle &c, int limit, int nsols, const unsigned char *solution) {
+		Entry e;
+		pack_cells(c.cells, e.key);
+		if ( nsols ) {
+			pack_cells(solution, e.solution, nsols);
+		} else {
+			memset(e.solution, 0, sizeof(e.solution));
+		}
+		e.limit = limit;
+		e.reserved = 0;
+		e.check = e.checksum();
+		store(hash(e.key), e);
+	}
+
+	private:
+	static const unsigned int nlocks = 64;
+	static const uint16_t version = 1;
+
+	//start of a cache file, the sets of entries follow
+	class FileHeader {
+		public:
+		unsigned char magic[4] = { 'S', 'D', 'K', 'C' };
+		uint16_t version = SolutionCache::version;
+		uint16_t ways = SolutionCache::ways;
+		uint32_t entry_size = sizeof(Entry);
+		uint32_t reserved = 0;
+		uint64_t nsets = 0;
+		unsigned char pad[sizeof(Entry)-24] = {};
+	};
+	static_assert(sizeof(FileHeader) == sizeof(Entry), "cache file header layout");
+
+	size_t nsets;
+	Entry *table = nullptr;
+	void *base = nullptr;		// start of the mapping, the file header if there is one
+	size_t mapped = 0;
+	int fd = -1;
+	std::mutex locks[nlocks];
+
+	//fnv-1a of a packed grid
+	static inline uint64_t hash(const unsigned char *key) {
+		uint64_t h = 14695981039346656037ull;
+		for ( size_t i=0; i<PackedHeader::record_size; i++ ) {
+			h = (h ^ key[i]) * 1099511628211ull;
+		}
+		return h;
+	}
+
+	inline bool lookup(uint64_t h, const unsigned char *key, Entry &out) {
+		if ( nsets == 0 ) {
+			return false;
+		}
+		size_t set = h & (nsets-1);
+		std::lock_guard<std::mutex> guard(locks[set % nlocks]);
+		Entry *e = table + set*ways;
+		for ( unsigned int w=0; w<ways; w++ ) {
+			if ( memcmp(e[w].key, key, sizeof(e[w].key)) == 0 && e[w].check == e[w].checksum() ) {
+				out = e[w];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline void store(uint64_t h, const Entry &entry) {
+		if ( nsets == 0 ) {
+			return;
+		}
+		size_t set = h & (nsets-1);
+		std::lock_guard<std::mutex> guard(locks[set % nlocks]);
+		Entry *e = table + set*ways;
+		unsigned int to = (h >> 32) % ways;
+		for ( unsigned int w=0; w<ways; w++ ) {
+			bool valid = e[w].check == e[w].checksum();
+			if ( valid && memcmp(e[w].key, entry.key, sizeof(entry.key)) == 0 ) {
+				if ( e[w].limit >= entry.limit ) {
+					return;
+				}
+				to = w;
+				break;
+			}
+			if ( !valid ) {
+				to = w;
+			}
+		}
+		e[to] = entry;
+	}
+
+	//map the table of file fn, creating the file with nsets sets if it is empty
+	//returns false if the file cannot be opened or is not a cache file
+	bool open_file(const char *fn) {
+		fd = open(fn, O_RDWR|O_CREAT, 0664);
+		if ( fd == -1 ) {
+			snprintf(error, sizeof(error), "Error opening %s: %s", fn, strerror(errno));
+			return false;
+		}
+		struct stat sb;
+		FileHeader hdr;
+		if ( fstat(fd, &sb) == -1 ) {
+			snprintf(error, sizeof(error), "Error reading %s: %s", fn, strerror(errno));
+			return close_file();
+		}
+		if ( sb.st_size == 0 ) {
+			hdr.nsets = nsets;
+			if ( ftruncate(fd, (1+nsets*ways)*sizeof(Entry)) == -1 || pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ) {
+				snprintf(error, sizeof(error), "Error writing %s: %s", fn, strerror(errno));
+				return close_file();
+			}
+		} else {
+			FileHeader want;
+			if ( pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) || memcmp(hdr.magic, want.magic, 4) != 0 ||
+				 hdr.version != version || hdr.ways != ways || hdr.entry_size != sizeof(Entry) ||
+				 hdr.nsets == 0 || (hdr.nsets & (hdr.nsets-1)) != 0 ||
+				 (uint64_t)sb.st_size != (1+hdr.nsets*ways)*sizeof(Entry) ) {
+				snprintf(error, sizeof(error), "%s is not a version %d solution cache", fn, version);
+				return close_file();
+			}
+			nsets = hdr.nsets;
+		}
+		mapped = (1+nsets*ways)*sizeof(Entry);
+		base = mmap(nullptr, mapped, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		if ( base == MAP_FAILED ) {
+			snprintf(error, sizeof(error), "Error mmap of %s: %s", fn, strerror(errno));
+			base = nullptr;
+			return close_file();
+		}
+		table = (Entry *)base + 1;
+		return true;
+	}
+
+	inline bool close_file() {
+		close(fd);
+		fd = -1;
+		return false;
+	}
+};
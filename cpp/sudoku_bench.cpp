@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <errno.h>
+#include "work_scheduler.hpp"
+#include "dlinks_matrix.hpp"
+#include "bitboard_solver.hpp"
+#include "exact_cover.hpp"
+#include "parallel_cover.hpp"
+#include "sudoku_cover.hpp"
+
+//Benchmarks of the solver engines, one JSON object per line on stdout
+//  micro   - cover+uncover of each row (its 4 columns) on the empty grid matrix, and solve_puzzle on fixed puzzles,
+//            a 16x16 one included, and counting the N queens solutions with the exact cover engine
+//  tier    - ns per puzzle (mean and percentiles) and puzzles/s on the 17-clue puzzles of the
+//            input file, on a set of very hard puzzles and on random puzzles
+//  threads - puzzles/s of the 17-clue tier solved by 1..N threads and the scaling efficiency
+//            against 1 thread, and the same for counting the 12 queens solutions and searching
+//            the 16x16 puzzle with the parallel search of a single exact cover problem
+//The puzzles are solved in memory, reading and writing files is left out.
+
+typedef std::vector<unsigned char> Puzzle;
+
+// well known hard puzzles, each with a unique solution
+const char *hard_puzzles[] = {
+	"1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",	// AI Escargot
+	"1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1",	// Easter Monster
+	"8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",	// Inkala 2012
+	"4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+	"..53.....8......2..7..1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+	"12.3....435....1....4........54..2..6...7.........8.9...31..5.......9.7.....6...8",
+	"..3......4...8..36..8...1...4..6..73...9..........2..5..4.7..686........7..6..5..",
+	"6.....8.3.4.7.................5.4.7.3..2.....1.6.......2.....5.....8.6......1....",
+	"48.3............71.2.......7.5....6....2..8.............1.76...3.....4......5....",
+};
+
+// 16x16 sample of the C version, 'A'-'G' for 10-16
+const char *puzzle_16x16 =
+	"F..D.EB83..14..738..F26.....1.E.6.1.A7.CF.5.2.B3B....3..4.DE...6"
+	"83AF.GD.7..6E5.C...1..E.D..F67..72C684.A59.G.B1F.DE.76.......2.."
+	".5B.ED.......3..172AC8.463.5.E9D...3..A.9..4CG..E498.F2.C..B76.A"
+	"C....A..G.9D...2A.D.41.2E.6.9.8B2F..697.....A.D.9..E.C831..25..G";
+
+// hard 16x16 with a unique solution: the sample's solution with clues taken out while one
+// solution is left, about 700k branches to rule out a second one
+const char *puzzle_16x16_hard =
+	".A5.G...3..1..C...4........7.A......A.4..8.9......7...15..D.F8G6"
+	"83AF..D9.....54....1.5E..C.F.7A...C.......E.DB....E..6..A.1.G.3."
+	"G..........A..F...2.C..4.3..BE.DD6F.....9E84.....4..3.2.....7..."
+	"....B.5EG..D.F.2.GD.4..2....9......5..7.8.4CA.D.9B....8.1..2.47G";
+
+double elapsed_ns(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+//read up to max puzzles of 81 cells from a text file
+std::vector<Puzzle> read_puzzles(const char *fn, size_t max) {
+	std::vector<Puzzle> puzzles;
+	FILE *f = fopen(fn, "r");
+	if ( f == NULL ) {
+		fprintf(stderr, "Error opening file %s: %s\n", fn, strerror(errno));
+		exit(0);
+	}
+	char line[256];
+	while ( puzzles.size() < max && fgets(line, sizeof(line), f) ) {
+		if ( strspn(line, "0123456789.") == 81 ) {
+			puzzles.emplace_back(line, line+81);
+		}
+	}
+	fclose(f);
+	return puzzles;
+}
+
+//random puzzles made from the solutions of the given ones: the digits are relabeled and
+//22 to 30 random cells kept, so the puzzles may have several solutions
+std::vector<Puzzle> random_puzzles(const std::vector<Puzzle> &from, size_t n) {
+	std::mt19937 rng(81);
+	BitBoard *bb = new BitBoard;
+	std::vector<Puzzle> puzzles;
+	unsigned char grid[81];
+	for ( size_t i=0; i<n && !from.empty(); i++ ) {
+		Puzzle p = from[i % from.size()];
+		if ( solve_puzzle(bb, p.data()) == 0 ) {
+			continue;
+		}
+		write_solution(bb, grid);
+		unsigned char digits[9] = { '1','2','3','4','5','6','7','8','9' };
+		std::shuffle(digits, digits+9, rng);
+		int cells[81];
+		for ( int c=0; c<81; c++ ) {
+			cells[c] = c;
+		}
+		std::shuffle(cells, cells+81, rng);
+		int keep = 22 + rng() % 9;
+		memset(p.data(), '0', 81);
+		for ( int k=0; k<keep; k++ ) {
+			p[cells[k]] = digits[grid[cells[k]]-'1'];
+		}
+		puzzles.push_back(p);
+	}
+	delete bb;
+	return puzzles;
+}
+
+//take the row of node n into the cover and back out as the search does: the columns of its
+//4 nodes left to right, then uncovered right to left
+inline void cover_uncover_row(DLinks *dl, DLinks::Node *n) {
+	DLinks::Node *h = n;
+	do {
+		dl->cover(h);
+	} while ( (h = h->right) != n );
+	h = n->left;
+	do {
+		dl->uncover(h);
+	} while ( (h = h->left) != n->left );
+}
+
+inline void cover_uncover_row(DLinksCompact *dl, DLinksCompact::Index n) {
+	DLinksCompact::Index h = n;
+	do {
+		dl->cover(h);
+	} while ( (h = dl->link[h].right) != n );
+	h = dl->link[n].left;
+	do {
+		dl->uncover(h);
+	} while ( (h = dl->link[h].left) != dl->link[n].left );
+}
+
+//ns per cover and uncover of each row of the empty grid matrix, all 4 columns of the row
+template<class Engine>
+void bench_cover(const char *engine, int reps) {
+	Engine *dl = new Engine;
+	dl->restore();
+	dl->assign_column_headers();
+	auto start = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ ) {
+		for ( int row=0; row<729; row++ ) {
+			cover_uncover_row(dl, dl->row_node(row));
+		}
+	}
+	printf("{\"bench\":\"micro\",\"name\":\"cover_uncover_row\",\"engine\":\"%s\",\"ops\":%d,\"ns_per_op\":%.1f}\n",
+		engine, 729*reps, elapsed_ns(start) / (729.0*reps));
+	delete dl;
+}
+
+//ns per solve of each fixed puzzle
+template<class Engine>
+void bench_fixed(const char *engine, const std::vector<Puzzle> &puzzles, const char *name, int reps) {
+	Engine *e = new Engine;
+	for ( size_t i=0; i<puzzles.size(); i++ ) {
+		Puzzle p = puzzles[i];
+		auto start = std::chrono::steady_clock::now();
+		for ( int r=0; r<reps; r++ ) {
+			solve_puzzle(e, p.data());
+		}
+		printf("{\"bench\":\"micro\",\"name\":\"solve_%s_%zu\",\"engine\":\"%s\",\"ops\":%d,\"ns_per_op\":%.1f}\n",
+			name, i, engine, reps, elapsed_ns(start) / reps);
+	}
+	delete e;
+}
+
+//N queens as an exact cover problem: a primary column per rank and file, a secondary
+//column per diagonal
+template<int N>
+using Queens = ExactCover<6*N-2, 4*N*N, N, 2*N>;
+
+template<int N>
+Queens<N> *load_queens() {
+	auto *ec = new Queens<N>;
+	for ( int r=0; r<N; r++ ) {
+		for ( int f=0; f<N; f++ ) {
+			int cols[4] = { r, N+f, 2*N+r+f, 5*N-2+r-f };
+			ec->add_row(cols, 4);
+		}
+	}
+	return ec;
+}
+
+//ns per count of all N queens placements with ExactCover
+template<int N>
+void bench_queens(int reps) {
+	Queens<N> *ec = load_queens<N>();
+	unsigned long nsols = 0;
+	auto start = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ ) {
+		nsols = ec->search(0);
+	}
+	printf("{\"bench\":\"micro\",\"name\":\"queens_%d\",\"engine\":\"exact_cover\",\"ops\":%d,\"solutions\":%lu,\"ns_per_op\":%.1f}\n",
+		N, reps, nsols, elapsed_ns(start) / reps);
+	delete ec;
+}
+
+//ns per count of all N queens placements by ParallelCover with 1..maxthreads threads
+template<int N>
+void bench_parallel_queens(unsigned int maxthreads) {
+	Queens<N> *ec = load_queens<N>();
+	double base = 0;
+	for ( unsigned int nthreads=1; nthreads<=maxthreads; nthreads++ ) {
+		ParallelCover<Queens<N>> *pc = new ParallelCover<Queens<N>>(nthreads);
+		auto start = std::chrono::steady_clock::now();
+		unsigned long nsols = pc->search(*ec);
+		double ns = elapsed_ns(start);
+		if ( nthreads == 1 ) {
+			base = ns;
+		}
+		printf("{\"bench\":\"threads\",\"name\":\"queens_%d\",\"engine\":\"parallel_cover\",\"threads\":%u,\"solutions\":%lu,"
+			"\"tasks\":%lu,\"ns\":%.0f,\"efficiency\":%.3f}\n",
+			N, nthreads, nsols, pc->ntasks, ns, base / (ns*nthreads));
+		delete pc;
+	}
+	delete ec;
+}
+
+//ns per search of the B*B x B*B puzzle by ParallelCover with 1..maxthreads threads, loaded with
+//load_sudoku; the search goes on for a second solution, so it walks the whole tree, and the
+//grid written back by write_sudoku must match the one DancingLinks finds
+template<int B>
+void bench_parallel_sudoku(const char *name, const char *puzzle, unsigned int maxthreads) {
+	const int ncells = CoverTables<B>::ncells;
+	DancingLinks<DLINKS_SELECT, B> *dl = new DancingLinks<DLINKS_SELECT, B>;
+	Puzzle expect(ncells);
+	if ( solve_puzzle(dl, (const unsigned char *)puzzle) ) {
+		write_solution(dl, expect.data());
+	}
+	delete dl;
+	SudokuCover<B> *ec = new SudokuCover<B>;
+	if ( !load_sudoku<B>(*ec, (const unsigned char *)puzzle) ) {
+		fprintf(stderr, "puzzle %s has clashing givens\n", name);
+		delete ec;
+		return;
+	}
+	double base = 0;
+	for ( unsigned int nthreads=1; nthreads<=maxthreads; nthreads++ ) {
+		ParallelCover<SudokuCover<B>> *pc = new ParallelCover<SudokuCover<B>>(nthreads);
+		auto start = std::chrono::steady_clock::now();
+		unsigned long nsols = pc->search(*ec, 2);
+		double ns = elapsed_ns(start);
+		if ( nthreads == 1 ) {
+			base = ns;
+		}
+		Puzzle grid(ncells, '.');
+		write_sudoku<B>(*ec, pc->solution, pc->solution_size, grid.data());
+		printf("{\"bench\":\"threads\",\"name\":\"%s\",\"engine\":\"parallel_cover\",\"threads\":%u,\"solutions\":%lu,"
+			"\"tasks\":%lu,\"ns\":%.0f,\"efficiency\":%.3f,\"valid\":%s}\n",
+			name, nthreads, nsols, pc->ntasks, ns, base / (ns*nthreads), nsols && grid == expect ? "true" : "false");
+		delete pc;
+	}
+	delete ec;
+}
+
+//ns per puzzle of a tier, every puzzle timed on its own
+template<class Engine>
+void bench_tier(const char *engine, const std::vector<Puzzle> &puzzles, const char *tier) {
+	if ( puzzles.empty() ) {
+		return;
+	}
+	Engine *e = new Engine;
+	std::vector<double> ns(puzzles.size());
+	double total = 0;
+	for ( size_t i=0; i<puzzles.size(); i++ ) {
+		Puzzle p = puzzles[i];
+		auto start = std::chrono::steady_clock::now();
+		solve_puzzle(e, p.data());
+		total += ns[i] = elapsed_ns(start);
+	}
+	std::sort(ns.begin(), ns.end());
+	auto pct = [&](double q) { return ns[(size_t)(q * (ns.size()-1))]; };
+	printf("{\"bench\":\"tier\",\"tier\":\"%s\",\"engine\":\"%s\",\"puzzles\":%zu,\"puzzles_per_s\":%.0f,"
+		"\"ns_mean\":%.0f,\"ns_p50\":%.0f,\"ns_p90\":%.0f,\"ns_p99\":%.0f,\"ns_max\":%.0f}\n",
+		tier, engine, puzzles.size(), puzzles.size() / (total*1e-9), total / puzzles.size(),
+		pct(0.5), pct(0.9), pct(0.99), ns.back());
+	delete e;
+}
+
+//puzzles/s with 1..maxthreads threads sharing the puzzles through the work scheduler
+template<class Engine>
+void bench_threads(const char *engine, const std::vector<Puzzle> &puzzles, unsigned int maxthreads) {
+	double base = 0;
+	for ( unsigned int nthreads=1; nthreads<=maxthreads; nthreads++ ) {
+		WorkScheduler sched(0, puzzles.size());
+		auto work = [&] {
+			Engine *e = new Engine;
+			unsigned char p[81];
+			size_t first, n;
+			while ( (n = sched.claim(64, first)) > 0 ) {
+				for ( size_t i=0; i<n; i++ ) {
+					memcpy(p, puzzles[first+i].data(), 81);
+					solve_puzzle(e, p);
+				}
+			}
+			delete e;
+		};
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for ( unsigned int i=1; i<nthreads; i++ ) {
+			threads.emplace_back(work);
+		}
+		work();
+		for ( auto &t : threads ) {
+			t.join();
+		}
+		double rate = puzzles.size() / (elapsed_ns(start)*1e-9);
+		if ( nthreads == 1 ) {
+			base = rate;
+		}
+		printf("{\"bench\":\"threads\",\"engine\":\"%s\",\"threads\":%u,\"puzzles\":%zu,\"puzzles_per_s\":%.0f,\"efficiency\":%.3f}\n",
+			engine, nthreads, puzzles.size(), rate, rate / (base*nthreads));
+	}
+}
+
+template<class Engine>
+void bench_engine(const char *engine, const std::vector<Puzzle> &clue17, const std::vector<Puzzle> &hard,
+		const std::vector<Puzzle> &random, unsigned int maxthreads) {
+	std::vector<Puzzle> fixed(clue17.begin(), clue17.begin() + std::min<size_t>(3, clue17.size()));
+	bench_fixed<Engine>(engine, fixed, "17clue", 2000);
+	bench_fixed<Engine>(engine, hard, "hard", 20);
+	bench_tier<Engine>(engine, clue17, "17-clue");
+	bench_tier<Engine>(engine, hard, "hard");
+	bench_tier<Engine>(engine, random, "random");
+	bench_threads<Engine>(engine, clue17, maxthreads);
+	fflush(stdout);
+}
+
+//accepts options followed by up to 1 argument:
+//  -e engine - benchmark only this engine: "dlinks", "compact" or "bitboard"
+//  -n count  - puzzles per tier, 10000 by default
+//  -t n      - measure 1..n threads, defaults to the number of hardware threads
+//  1 - file of 17-clue puzzles, defaults to "puzzles.txt"
+int main(int argc, char *argv[]) {
+	const char *only = nullptr;
+	size_t count = 10000;
+	unsigned int maxthreads = 0;
+	int opt;
+	while ( (opt = getopt(argc, argv, "e:n:t:")) != -1 ) {
+		switch ( opt ) {
+		case 'e':
+			only = optarg;
+			if ( strcmp(only, "dlinks") != 0 && strcmp(only, "compact") != 0 && strcmp(only, "bitboard") != 0 ) {
+				printf("Unknown engine %s, expected dlinks, compact or bitboard\n", only);
+				exit(0);
+			}
+			break;
+		case 'n':
+			count = strtoul(optarg, nullptr, 10);
+			if ( !isdigit((unsigned char)optarg[0]) || count == 0 ) {
+				printf("-n expects a number of puzzles, got %s\n", optarg);
+				exit(0);
+			}
+			break;
+		case 't':
+			maxthreads = strtoul(optarg, nullptr, 10);
+			if ( !isdigit((unsigned char)optarg[0]) || maxthreads == 0 || maxthreads > 4096 ) {
+				printf("-t expects a number from 1 to 4096, got %s\n", optarg);
+				exit(0);
+			}
+			break;
+		default:
+			printf("Usage: sb [-e dlinks|compact|bitboard] [-n count] [-t threads] [puzzles.txt]\n");
+			exit(0);
+		}
+	}
+	argv += optind; argc -= optind;
+	if ( maxthreads == 0 ) {
+		maxthreads = std::thread::hardware_concurrency();
+		if ( maxthreads == 0 ) {
+			maxthreads = 8;
+		}
+	}
+
+	std::vector<Puzzle> clue17 = read_puzzles(argc > 0 ? argv[0] : "puzzles.txt", count);
+	std::vector<Puzzle> hard;
+	for ( const char *p : hard_puzzles ) {
+		hard.emplace_back(p, p+81);
+	}
+	std::vector<Puzzle> random = random_puzzles(clue17, count);
+
+	if ( !only || strcmp(only, "dlinks") == 0 ) {
+		bench_cover<DLinks>("dlinks", 200);
+	}
+	if ( !only || strcmp(only, "compact") == 0 ) {
+		bench_cover<DLinksCompact>("compact", 200);
+	}
+	if ( !only || strcmp(only, "dlinks") == 0 ) {
+		bench_engine<DLinks>("dlinks", clue17, hard, random, maxthreads);
+		std::vector<Puzzle> grid16 = { Puzzle(puzzle_16x16, puzzle_16x16+256) };
+		bench_fixed<DancingLinks<DLINKS_SELECT, 4>>("dlinks", grid16, "16x16", 200);
+		bench_queens<8>(100);
+		bench_queens<10>(10);
+		bench_parallel_queens<12>(maxthreads);
+		bench_parallel_sudoku<4>("sudoku_16x16_hard", puzzle_16x16_hard, maxthreads);
+	}
+	if ( !only || strcmp(only, "compact") == 0 ) {
+		bench_engine<DLinksCompact>("compact", clue17, hard, random, maxthreads);
+	}
+	if ( !only || strcmp(only, "bitboard") == 0 ) {
+		bench_engine<BitBoard>("bitboard", clue17, hard, random, maxthreads);
+	}
+	return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "puzzle_index.hpp"
+#include "packed_format.hpp"
+
+//read all of fd into buf
+void read_all(int fd, std::vector<unsigned char> &buf, const char *fn) {
+	size_t have = 0;
+	while ( true ) {
+		if ( have == buf.size() ) {
+			buf.resize(buf.size() ? 2*buf.size() : 1<<20);
+		}
+		ssize_t r = read(fd, buf.data()+have, buf.size()-have);
+		if ( r == 0 ) {
+			break;
+		}
+		if ( r == -1 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			fprintf(stderr, "Error reading %s: %s\n", fn, strerror(errno));
+			exit(1);
+		}
+		have += r;
+	}
+	buf.resize(have);
+}
+
+//converts between text and packed files, the direction follows from the input:
+//  text puzzles     -> packed puzzle file
+//  packed puzzles   -> text puzzles, one per line
+//  packed solutions -> text solutions, one per line, with the solution count as a second column
+//accepts up to 2 arguments, the input and output files, both default to "-" for stdin and stdout
+int main(int argc, char *argv[]) {
+	if ( argc > 3 || (argc > 1 && argv[1][0] == '-' && argv[1][1] != 0) ) {
+		printf("Usage: sc [input [output]]\n");
+		exit(0);
+	}
+	const char *ifn = argc > 1 ? argv[1] : "-";
+	const char *ofn = argc > 2 ? argv[2] : "-";
+	int fdin = strcmp(ifn, "-") == 0 ? 0 : open(ifn, O_RDONLY);
+	if ( fdin == -1 ) {
+		fprintf(stderr, "Error opening file %s: %s\n", ifn, strerror(errno));
+		exit(1);
+	}
+	FILE *out = strcmp(ofn, "-") == 0 ? stdout : fopen(ofn, "wb");
+	if ( out == NULL ) {
+		fprintf(stderr, "Error opening output file %s: %s\n", ofn, strerror(errno));
+		exit(1);
+	}
+
+	std::vector<unsigned char> in;
+	read_all(fdin, in, ifn);
+	std::vector<unsigned char> buf;
+	PackedHeader hdr;
+	size_t records = 0, bad = 0;
+	if ( hdr.read(in.data(), in.size()) ) {
+		if ( hdr.version != PackedHeader::current_version ) {
+			fprintf(stderr, "%s: unsupported packed version %d\n", ifn, hdr.version);
+			exit(1);
+		}
+		bool solutions = hdr.kind == PackedHeader::solutions;
+		size_t linesize = solutions ? 84 : 82;
+		records = (in.size() - PackedHeader::size) / PackedHeader::record_size;
+		size_t extra = (in.size() - PackedHeader::size) % PackedHeader::record_size;
+		if ( extra ) {
+			fprintf(stderr, "%s ends with %zu bytes of an incomplete record\n", ifn, extra);
+			bad++;
+		}
+		if ( hdr.count != PackedHeader::unknown_count && hdr.count != records ) {
+			fprintf(stderr, "%s: header counts %lu records, found %zu\n", ifn, (unsigned long)hdr.count, records);
+		}
+		buf.resize(records*linesize);
+		for ( size_t i=0; i<records; i++ ) {
+			unsigned char *line = buf.data()+i*linesize;
+			int spare = unpack_cells(in.data()+PackedHeader::size+i*PackedHeader::record_size, line);
+			if ( spare < 0 ) {
+				fprintf(stderr, "%s: record %zu has an invalid cell\n", ifn, i+1);
+				bad++;
+			}
+			if ( solutions ) {
+				if ( spare <= 0 ) {
+					memcpy(line, "No solution                                                                      ", 81);
+				}
+				line[81] = ',';
+				line[82] = '0' + (spare < 0 ? 0 : spare);
+			}
+			line[linesize-1] = '\n';
+		}
+	} else {
+		PuzzleIndex index(ifn);
+		std::vector<size_t> offsets;
+		index.scan(in.data(), 0, in.size(), true, offsets);
+		records = offsets.size();
+		bad = index.rejected;
+		buf.resize(PackedHeader::size + records*PackedHeader::record_size);
+		PackedHeader(PackedHeader::puzzles, records).write(buf.data());
+		for ( size_t i=0; i<records; i++ ) {
+			pack_cells(in.data()+offsets[i], buf.data()+PackedHeader::size+i*PackedHeader::record_size);
+		}
+	}
+
+	if ( fwrite(buf.data(), 1, buf.size(), out) != buf.size() || fflush(out) != 0 ) {
+		fprintf(stderr, "Error writing %s: %s\n", ofn, strerror(errno));
+		exit(1);
+	}
+	if ( out != stdout ) {
+		fclose(out);
+	}
+	fprintf(stderr, "%zu records converted, %zu rejected\n", records, bad);
+	return 0;
+}
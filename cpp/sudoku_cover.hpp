@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include "dlinks_matrix.hpp"
+#include "exact_cover.hpp"
+
+//A sudoku with boxes of B x B cells as an ExactCover problem, for searching one puzzle with
+//ParallelCover: the columns and rows are those of DancingLinks<_,B> (see CoverTables), 4*side^2
+//columns, 2500 for 25x25. The matrix is large (about 3MB of nodes for B=5), allocate it with new.
+template<int B>
+using SudokuCover = ExactCover<4*CoverTables<B>::ncells, 4*CoverTables<B>::nrows, CoverTables<B>::side>;
+
+//load puzzle (ncells symbols, see digit_of) into ec: the row of its digit for a given cell and the
+//rows of the digits no given peer holds for an empty one
+//returns false if two givens clash, ec is then not a valid problem
+template<int B>
+bool load_sudoku(SudokuCover<B> &ec, const unsigned char *puzzle) {
+	typedef CoverTables<B> T;
+	const T &t = cover_tables<B>;
+	uint32_t rows[T::side] = {}, cols[T::side] = {}, boxes[T::side] = {};	// digits given in each house
+	ec.clear();
+	for(int cell=0; cell<T::ncells; ++cell) {
+		int d = digit_of(puzzle[cell]);
+		if(d > T::side) {
+			return false;
+		}
+		if(!d) {
+			continue;
+		}
+		uint32_t bit = 1u << (d-1);
+		int gr = cell/T::side, gc = cell%T::side, gb = (gr/B)*B + gc/B;
+		if((rows[gr] | cols[gc] | boxes[gb]) & bit) {
+			return false;
+		}
+		rows[gr] |= bit;
+		cols[gc] |= bit;
+		boxes[gb] |= bit;
+	}
+	for(int cell=0; cell<T::ncells; ++cell) {
+		int d = digit_of(puzzle[cell]);
+		int gr = cell/T::side, gc = cell%T::side, gb = (gr/B)*B + gc/B;
+		uint32_t taken = rows[gr] | cols[gc] | boxes[gb];
+		for(int k=0; k<T::side; ++k) {
+			if(d ? k != d-1 : (taken >> k) & 1) {
+				continue;
+			}
+			int r = cell*T::side + k;
+			int row[4] = { t.one[r], t.row[r], t.col[r], t.box[r] };
+			ec.add_row(row, 4);
+		}
+	}
+	return true;
+}
+
+//write the cover of rows[0..n) found in ec (ParallelCover::solution or ec.solution) to out as
+//ncells symbols
+template<int B>
+void write_sudoku(const SudokuCover<B> &ec, const int *rows, int n, unsigned char *out) {
+	typedef CoverTables<B> T;
+	for(int k=0; k<n; ++k) {
+		// each row has 4 nodes, the cell column first and then the row house one
+		const auto *node = &ec.nodes[4*rows[k]];
+		out[node[0].col] = symbol_of((node[1].col - T::ncells) % T::side + 1);
+	}
+}
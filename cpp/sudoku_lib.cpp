@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include "sudoku_lib.hpp"
+#include "work_scheduler.hpp"
+#include "thread_affinity.hpp"
+#include "packed_format.hpp"
+#include "output_writer.hpp"
+#include "solution_cache.hpp"
+
+//the puzzles and solutions of one batch call, shared by its threads
+class SudokuContext::Job {
+	public:
+	const unsigned char *puzzles;	// the input, text or packed records
+	const size_t *index;		// offset of each puzzle in the input, or null if they are stride apart
+	size_t stride;
+	bool packed;				// the puzzles are packed records
+	unsigned char *solutions;	// solutions are spaced solsize bytes, unless written through writer
+	OutputWriter *writer;		// if set, each batch of solutions is submitted to it
+	PuzzleStats *stats;			// counters of each puzzle, with SEARCH_STATS
+	size_t npuzzles;
+	std::deque<WorkScheduler> slices;	// the puzzles in contiguous slices, one per thread or a single one
+
+	//the puzzles in nslices slices, or in those of writer if it is set
+	Job(const unsigned char *puzzles, const size_t *index, size_t stride, bool packed,
+		unsigned char *solutions, OutputWriter *writer, PuzzleStats *stats, size_t npuzzles, unsigned int nslices)
+		: puzzles(puzzles), index(index), stride(stride), packed(packed), solutions(solutions),
+		  writer(writer), stats(stats), npuzzles(npuzzles) {
+		if ( writer ) {
+			// each slice of the writer goes on from its first record not written
+			for ( const OutputWriter::Slice &s : writer->progress() ) {
+				slices.emplace_back(s.next, s.end);
+			}
+			return;
+		}
+		for ( unsigned int i=0; i<nslices; i++ ) {
+			slices.emplace_back(npuzzles*i/nslices, npuzzles*(i+1)/nslices);
+		}
+	}
+
+	inline const unsigned char *puzzle(size_t i) const {
+		return index ? puzzles+index[i] : puzzles+i*stride;
+	}
+
+	//claim up to n puzzles from the slice of worker, or once it is done from the next slices
+	//returns the number of puzzles claimed, 0 once all are taken
+	inline size_t claim(unsigned int worker, size_t n, size_t &first) {
+		for ( size_t i=0; i<slices.size(); i++ ) {
+			size_t got = slices[(worker+i) % slices.size()].claim(n, first);
+			if ( got ) {
+				return got;
+			}
+		}
+		return 0;
+	}
+
+	//puzzles left in the slice of worker
+	inline size_t remaining(unsigned int worker) const {
+		return slices[worker % slices.size()].remaining();
+	}
+};
+
+SudokuContext::SudokuContext(const Options &options)
+	: cells_resolved(0), nbatches(0), nbranches(0), nbacktracks(0), cache_hits(0), invalid_records(0), opts(options), cache(nullptr) {
+	if ( opts.nthreads == 0 ) {
+		opts.nthreads = std::thread::hardware_concurrency();
+		if ( opts.nthreads == 0 ) {
+			opts.nthreads = 8;
+		}
+	}
+	solsize = opts.packed_out ? PackedHeader::record_size : opts.count_limit ? 166 : 164;
+	if ( opts.pin ) {
+		cpus = allowed_cpus();
+	}
+	if ( opts.cache_size || opts.cache_file ) {
+		cache = new SolutionCache(opts.cache_size ? opts.cache_size : SolutionCache::default_entries, opts.cache_file);
+	}
+	switch ( opts.engine ) {
+	case compact:
+		loop = &SudokuContext::thread_loop<DLinksCompact>;
+		break;
+	case bitboard:
+		loop = &SudokuContext::thread_loop<BitBoard>;
+		break;
+	default:
+		loop = &SudokuContext::thread_loop<DLinks>;
+	}
+}
+
+SudokuContext::~SudokuContext() {
+	delete cache;
+}
+
+const char *SudokuContext::cache_error() const {
+	return cache ? cache->error : "";
+}
+
+size_t SudokuContext::solve_batch(const unsigned char *puzzles, size_t stride, size_t n, unsigned char *solutions) {
+	Job job(puzzles, nullptr, stride, false, solutions, nullptr, nullptr, n, opts.pin ? opts.nthreads : 1);
+	return run(&job);
+}
+
+size_t SudokuContext::solve_batch(const unsigned char *puzzles, const size_t *index, bool packed, size_t n,
+		unsigned char *solutions, OutputWriter *writer, PuzzleStats *stats) {
+	Job job(puzzles, index, 0, packed, solutions, writer, stats, n, opts.pin ? opts.nthreads : 1);
+	return run(&job);
+}
+
+//solve all puzzles of the job with the calling thread and nthreads-1 helpers
+size_t SudokuContext::run(Job *job) {
+	if ( job->npuzzles == 0 || job->slices.empty() ) {
+		return 0;
+	}
+	std::vector<std::thread> threads;
+	for (unsigned int i=1; i<opts.nthreads; i++) {
+		threads.emplace_back( [=]{ (this->*loop)(job, i); } );
+	}
+	(this->*loop)(job, 0);
+
+	for (auto &t : threads) {
+		t.join();
+	}
+	return job->npuzzles;
+}
+
+//solve_one through the cache: a puzzle equivalent to one solved before gets the cached
+//solution mapped back to it, any other is solved with ws and added
+//solved is set if ws solved the puzzle, so its counters are those of the puzzle
+template<class Solver>
+static int solve_cached(SolutionCache &cache, Solver *ws, const unsigned char *puzzle, unsigned char *solution,
+		int limit, bool &solved) {
+	CanonicalPuzzle canon(puzzle);
+	unsigned char grid[81];
+	int nsols = cache.find(canon, limit, grid);
+	solved = nsols < 0;
+	if ( solved ) {
+		nsols = solve_one(ws, puzzle, solution, limit);
+		if ( nsols ) {
+			canon.to_canonical(solution, grid);
+		}
+		cache.add(canon, limit, nsols, grid);
+	} else if ( nsols ) {
+		canon.to_puzzle(grid, solution);
+	}
+	return nsols;
+}
+
+//solve batches of puzzles claimed from the job until all are taken
+//with opts.pin, the thread runs on a core of its own (the worker-th of the allowed ones) until
+//it returns, and its workspace is mapped and first touched there
+template<class Solver>
+void SudokuContext::thread_loop(Job *job, unsigned int worker) {
+	cpu_set_t affinity;
+	bool pinned = false;
+	if ( opts.pin && !cpus.empty() ) {
+		pinned = pin_thread(cpus[worker % cpus.size()], affinity);
+	}
+	LocalPtr<Solver> workspace(pinned);
+	Solver *dl = workspace.get();
+	BatchSizer sizer(opts.batchsize);
+	int limit = opts.count_limit ? opts.count_limit : 1;
+	unsigned long resolved = 0, batches = 0, branches = 0, backtracks = 0, hits = 0, invalid = 0;
+	unsigned char cells[81], sol[81];
+	size_t first, n;
+	while ( true ) {
+		// take the buffer before the claim, so a claimed batch never waits for the writer
+		OutputWriter::Batch *batch = job->writer ? job->writer->get(opts.pin ? (int)worker : -1) : nullptr;
+		n = job->claim(worker, sizer.next(job->remaining(worker), job->slices.size() > 1 ? 1 : opts.nthreads), first);
+		if ( n == 0 ) {
+			if ( batch ) {
+				job->writer->release(batch);
+			}
+			break;
+		}
+		auto start = std::chrono::steady_clock::now();
+		++batches;
+		unsigned char *outbase = batch ? batch->reserve(n, solsize) : job->solutions+first*solsize;
+
+		for ( size_t i=0; i<n; i++ ) {
+			const unsigned char *puzzle = job->puzzle(first+i);
+			unsigned char *out = outbase+i*solsize;
+			SEARCH_STAT(auto solve_start = std::chrono::steady_clock::now();)
+			bool valid = true;
+			if ( job->packed ) {
+				valid = unpack_cells(puzzle, cells) >= 0;
+				puzzle = cells;
+				invalid += !valid;
+			}
+			int nsols = 0;
+			bool solved = valid;
+			if ( valid ) {
+				nsols = cache ? solve_cached(*cache, dl, puzzle, sol, limit, solved) : solve_one(dl, puzzle, sol, limit);
+			}
+			if ( solved ) {
+				resolved += dl->resolved;
+				branches += dl->branches;
+				backtracks += dl->backtracks;
+			} else if ( valid ) {
+				++hits;
+			}
+#ifdef SEARCH_STATS
+			if ( job->stats ) {
+				PuzzleStats &ps = job->stats[first+i];
+				ps.search = dl->stats;
+				ps.branches = dl->branches;
+				ps.backtracks = dl->backtracks;
+				ps.nsols = nsols;
+				ps.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - solve_start).count();
+				if ( !solved ) {
+					ps.search.reset();
+					ps.branches = ps.backtracks = 0;
+				}
+			}
+#endif
+
+			if ( opts.packed_out ) {
+				if ( !nsols ) {
+					memset(sol, '0', 81);
+				}
+				pack_cells(sol, out, nsols);
+				continue;
+			}
+			memcpy(out, puzzle, 81);
+			out[81] = ',';
+	        if(nsols) {
+				memcpy(out+82, sol, 81);
+			} else {
+				memcpy(out+82, "No solution                                                                      ", 81);
+			}
+			if ( opts.count_limit ) {
+				out[163] = ',';
+				out[164] = '0' + nsols;
+			}
+			out[solsize-1] = '\n';
+		}
+		if ( batch ) {
+			batch->first = first;
+			job->writer->submit(batch);
+		}
+		sizer.update(n, std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count());
+	}
+	cells_resolved += resolved;
+	nbatches += batches;
+	nbranches += branches;
+	nbacktracks += backtracks;
+	cache_hits += hits;
+	invalid_records += invalid;
+	if ( pinned ) {
+		restore_affinity(affinity);
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+#include "dlinks_matrix.hpp"
+#include "bitboard_solver.hpp"
+#include "search_stats.hpp"
+
+class OutputWriter;
+class SolutionCache;
+
+//Solver library, built as libsudoku.a
+//All state of a run lives in a SudokuContext or in the workspaces of its threads, so several
+//contexts can solve independently in one process, and one context can run batches from
+//several threads at once; nothing is shared between them but the read-only engine tables.
+
+//solve a puzzle of 81 cells ('0' or '.' for empty ones) with a workspace owned by the caller,
+//a DLinks, DLinksCompact or BitBoard that is reused from puzzle to puzzle by one thread;
+//a DancingLinks<_,4> or <_,5> workspace takes a 16x16 or 25x25 puzzle, the only way to solve
+//those, SudokuContext below handles 9x9 puzzles only
+//writes the 81 digits of the (first) solution to solution if there is one
+//returns the number of solutions, counting stops at limit
+template<class Engine>
+inline int solve_one(Engine *ws, const unsigned char *puzzle, unsigned char *solution, int limit = 1) {
+	int nsols = solve_puzzle(ws, puzzle, limit);
+	if ( nsols ) {
+		write_solution(ws, solution);
+	}
+	return nsols;
+}
+
+class SudokuContext {
+	public:
+	enum Engine { dlinks, compact, bitboard };
+
+	//settings of a context, fixed for its lifetime
+	class Options {
+		public:
+		Engine engine = dlinks;
+		unsigned int nthreads = 0;		// threads per batch, 0 for one per hardware thread
+		unsigned int batchsize = 0;		// puzzles per claim, 0 to tune it from the measured solve time
+		int count_limit = 0;			// if set, count solutions up to this limit and add a count column
+		bool packed_out = false;		// write packed solution records instead of text lines
+		bool pin = false;				// pin each thread to a core, with its workspace in memory of
+										// that core's node and a contiguous range of the puzzles
+		size_t cache_size = 0;			// entries of a cache of solutions of repeated and equivalent
+										// puzzles (see solution_cache.hpp), 0 for none
+		const char *cache_file = nullptr;	// if set, the cache is kept in this file across runs
+	};
+
+	SudokuContext(const Options &options);
+	~SudokuContext();
+
+	inline const Options &options() const { return opts; }
+	inline unsigned int threads() const { return opts.nthreads; }
+
+	//bytes per output record: a text line "puzzle,solution\n" of 164 bytes, 166 with the
+	//",count" column, or a 41 byte packed record (see packed_format.hpp)
+	inline unsigned int record_size() const { return solsize; }
+
+	//solve n puzzles of 81 cells stored stride bytes apart, writing the record of puzzle i
+	//to solutions+i*record_size(); puzzles and solutions stay in the caller's buffers
+	//returns n
+	size_t solve_batch(const unsigned char *puzzles, size_t stride, size_t n, unsigned char *solutions);
+
+	//solve n puzzles, puzzle i at puzzles+index[i], 81 cells or a packed record if packed
+	//the records go to solutions as above, or to writer in batches if it is set; then the
+	//puzzles solved are those of its slices (see OutputWriter) from the next of each, so a
+	//run can resume, and the threads work through one slice each with opts.pin
+	//with SEARCH_STATS, stats (if set) gets the counters of each puzzle, puzzle i at stats[i]
+	//a packed record with an invalid cell gets a no solution record and counts in invalid_records
+	//returns n
+	size_t solve_batch(const unsigned char *puzzles, const size_t *index, bool packed, size_t n,
+		unsigned char *solutions, OutputWriter *writer = nullptr, PuzzleStats *stats = nullptr);
+
+	// counters summed over all batches of the context
+	std::atomic<unsigned long> cells_resolved;	// empty cells resolved by propagation
+	std::atomic<unsigned long> nbatches;		// batches claimed by all threads
+	std::atomic<unsigned long> nbranches;		// branches of the searches
+	std::atomic<unsigned long> nbacktracks;		// backtracks of the searches
+	std::atomic<unsigned long> cache_hits;		// puzzles answered by the solution cache
+	std::atomic<unsigned long> invalid_records;	// packed records with a cell above 9, output as unsolvable
+
+	//why the cache file asked for could not be used (the cache is then kept in memory),
+	//empty if it could or there is none
+	const char *cache_error() const;
+
+	private:
+	class Job;
+
+	Options opts;
+	unsigned int solsize;
+	std::vector<int> cpus;		// cores the threads are pinned to, with opts.pin
+	SolutionCache *cache;		// shared by the threads, if opts asks for one
+	void (SudokuContext::*loop)(Job *, unsigned int);	// thread_loop of the engine
+
+	size_t run(Job *job);
+
+	template<class Solver>
+	void thread_loop(Job *job, unsigned int worker);
+};
@@ -1,70 +1,369 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
 #include <cstring>
 #include <thread>
+#include <chrono>
+#include <vector>
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
-#include "blockingQ.hpp"
-#include "dlinks_matrix.hpp"
+#include <sys/stat.h>
+#include "work_scheduler.hpp"
+#include "sudoku_lib.hpp"
+#include "puzzle_index.hpp"
+#include "packed_format.hpp"
+#include "output_writer.hpp"
+#include "checkpoint.hpp"
 
-class Buf {
-	public:
-	unsigned char *puzzle;		// batchsize puzzles are spaced 82 bytes.
-	unsigned char *solution;	// batchsize solutions are spaced 164 bytes. 
-	unsigned int batchsize;
+//read from fd until buf holds size bytes or the input ends
+//returns the number of bytes in buf
+size_t read_full(int fd, unsigned char *buf, size_t have, size_t size, const char *fn) {
+	while ( have < size ) {
+		ssize_t r = read(fd, buf+have, size-have);
+		if ( r == 0 ) {
+			break;
+		}
+		if ( r == -1 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			fprintf(stderr, "Error reading %s: %s\n", fn, strerror(errno));
+			exit(0);
+		}
+		have += r;
+	}
+	return have;
+}
 
-	Buf(unsigned char *puzzle, unsigned char *solution, unsigned int batchsize) {
-		this->puzzle = puzzle;
-		this->solution = solution;
-		this->batchsize = batchsize;
+void write_full(int fd, const unsigned char *buf, size_t size, const char *fn) {
+	while ( size > 0 ) {
+		ssize_t w = write(fd, buf, size);
+		if ( w == -1 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			fprintf(stderr, "Error writing %s: %s\n", fn, strerror(errno));
+			exit(0);
+		}
+		buf += w;
+		size -= w;
 	}
-};
+}
 
-unsigned int	batchsize = 16;
-const int 		nthreads  = 8;
-std::thread *threads[nthreads];
+void sync_output(int fd, const char *fn) {
+	if ( fdatasync(fd) == -1 ) {
+		fprintf(stderr, "Error syncing %s: %s\n", fn, strerror(errno));
+	}
+}
 
-void thread_loop(BlockingQueue<class Buf> *bq) {
-	DLinks *dl = new DLinks;
-	Buf b = { 0,0,0 };
+//append the offsets of the packed records in buf[pos,size) to offsets
+//returns the position after the last complete record
+size_t index_packed(size_t pos, size_t size, std::vector<size_t> &offsets) {
+	for ( ; pos+PackedHeader::record_size <= size; pos += PackedHeader::record_size ) {
+		offsets.push_back(pos);
+	}
+	return pos;
+}
+
+//check the header of a packed puzzle file
+void check_packed(const PackedHeader &hdr, const char *ifn) {
+	if ( hdr.version != PackedHeader::current_version || hdr.kind != PackedHeader::puzzles ) {
+		fprintf(stderr, "%s is not a version %d packed puzzle file\n", ifn, PackedHeader::current_version);
+		exit(0);
+	}
+}
+
+//solve the puzzles read from fdin in chunks and write the solutions to fdout in input order
+//Input and output are double buffered: while the threads solve one chunk, the main thread
+//writes out the solutions of the previous chunk and reads and indexes the next one, then
+//joins the solving. Batches finish out of order, but each writes its lines at their input
+//position in the chunk's output buffer, so the buffer serves as the reorder buffer.
+//returns the number of puzzles solved
+size_t stream_puzzles(SudokuContext &ctx, int fdin, int fdout, const char *ifn, const char *ofn,
+		OutputWriter::Durability durability, unsigned int sync_ms) {
+	const bool packed_out = ctx.options().packed_out;
+	const size_t solsize = ctx.record_size();
+	const size_t chunk = 1<<22;				// bytes of input per chunk
+	std::vector<unsigned char> in[2], out[2];
+	std::vector<size_t> offsets[2];
+	for (int i=0; i<2; i++) {
+		in[i].resize(chunk);
+	}
+
+	// reads the rest of a chunk after carry bytes and indexes its complete lines or records
+	// returns the number of bytes indexed, the rest is carried to the next chunk
+	PuzzleIndex index(ifn);
+	PackedHeader hdr;
+	bool packed = false;
+	bool skipline = false;	// drop the rest of a line that did not fit in a chunk
+	auto fill = [&](int i, size_t carry, size_t &have) {
+		have = read_full(fdin, in[i].data(), carry, chunk, ifn);
+		unsigned char *buf = in[i].data();
+		size_t pos = 0;
+		offsets[i].clear();
+		if ( packed ) {
+			size_t used = index_packed(0, have, offsets[i]);
+			if ( have < chunk && used < have ) {
+				fprintf(stderr, "%s ends with %zu bytes of an incomplete record\n", ifn, have-used);
+			}
+			return used;
+		}
+		if ( skipline ) {
+			while ( pos < have && buf[pos] != '\n' ) {
+				pos++;
+			}
+			skipline = pos == chunk;
+			pos += pos < have;
+		}
+		size_t used = index.scan(buf, pos, have, have < chunk, offsets[i]);
+		if ( used == 0 && have == chunk ) {
+			fprintf(stderr, "%s:%zu: line longer than %zu characters\n", ifn, ++index.lines, chunk);
+			index.rejected++;
+			skipline = true;
+			used = have;
+		}
+		return used;
+	};
+
+	// the first chunk tells the input format
+	size_t have = read_full(fdin, in[0].data(), 0, PackedHeader::size, ifn);
+	if ( hdr.read(in[0].data(), have) ) {
+		check_packed(hdr, ifn);
+		packed = true;
+		have = 0;
+	}
+	size_t maxpuzzles = packed ? chunk/PackedHeader::record_size : chunk/82+1;
+	for (int i=0; i<2; i++) {
+		out[i].resize(maxpuzzles*solsize);
+	}
+	off_t hdrat = lseek(fdout, 0, SEEK_CUR);	// -1 unless fdout is seekable
+	auto last_sync = std::chrono::steady_clock::now();
+	if ( packed_out ) {
+		unsigned char h[PackedHeader::size];
+		PackedHeader(PackedHeader::solutions).write(h);
+		write_full(fdout, h, sizeof(h), ofn);
+	}
+
+#ifdef SEARCH_STATS
+	StatsSidecar sidecar(ofn);
+	std::vector<PuzzleStats> stats(maxpuzzles);
+#endif
+
+	int cur = 0;
+	size_t total = 0, nprev = 0;
+	size_t used = fill(cur, have, have);
 	while ( true ) {
-		bq->take(b);
-		if ( b.batchsize == 0 ) {
+		size_t n = offsets[cur].size();
+		PuzzleStats *pstats = nullptr;
+		SEARCH_STAT(pstats = stats.data();)
+		std::thread solver([&]{
+			ctx.solve_batch(in[cur].data(), offsets[cur].data(), packed, n, out[cur].data(), nullptr, pstats);
+		});
+
+		if ( nprev ) {
+			write_full(fdout, out[cur^1].data(), nprev*solsize, ofn);
+			if ( durability == OutputWriter::periodic && hdrat != -1 &&
+				 std::chrono::steady_clock::now() - last_sync >= std::chrono::milliseconds(sync_ms) ) {
+				sync_output(fdout, ofn);
+				last_sync = std::chrono::steady_clock::now();
+			}
+		}
+		// the incomplete last line moves to the start of the next chunk
+		bool more = have == chunk;
+		if ( more ) {
+			size_t carry = have - used;
+			memmove(in[cur^1].data(), in[cur].data()+used, carry);
+			used = fill(cur^1, carry, have);
+		}
+
+		solver.join();
+		SEARCH_STAT(sidecar.add(stats.data(), n);)
+		total += n;
+		nprev = n;
+		cur ^= 1;
+		if ( !more ) {
 			break;
 		}
-		for ( unsigned int i=0; i<b.batchsize; i++ ) {
-			memcpy(b.solution+i*164, b.puzzle+i*82, 81);
-			b.solution[i*164+81] = ',';
-			b.solution[i*164+163] = '\n';
-	        if(solve_puzzle(dl, b.puzzle+i*82)) {
-				int index, value;
-				for(int j=0; j<81; j++) {
-					int row = dl->solution_stack[j]->row;
-					index = row / 9;
-					value = (row % 9) + '1';
-					b.solution[i*164+82+index] = value;
-				}
-			} else {
-				sprintf((char *)b.solution+i*164+82, "%-81s\n", "No solution");
-			}
+	}
+	if ( nprev ) {
+		write_full(fdout, out[cur^1].data(), nprev*solsize, ofn);
+	}
+	if ( index.rejected ) {
+		fprintf(stderr, "%zu of %zu lines rejected\n", index.rejected, index.lines);
+	}
+	// a seekable output gets the final count in its header
+	if ( packed_out && hdrat != -1 ) {
+		unsigned char h[PackedHeader::size];
+		PackedHeader(PackedHeader::solutions, total).write(h);
+		if ( pwrite(fdout, h, sizeof(h), hdrat) == -1 ) {
+			fprintf(stderr, "Error writing %s: %s\n", ofn, strerror(errno));
 		}
 	}
-	delete dl;
+	if ( durability != OutputWriter::none && hdrat != -1 ) {
+		sync_output(fdout, ofn);
+	}
+	SEARCH_STAT(sidecar.finish();)
+	return total;
+}
+
+//the value of option opt, a decimal number from 1 to max; anything else ends the program
+unsigned long parse_count(int opt, const char *arg, unsigned long max) {
+	char *end;
+	errno = 0;
+	unsigned long v = strtoul(arg, &end, 10);
+	if ( !isdigit((unsigned char)arg[0]) || *end != '\0' || errno == ERANGE || v == 0 || v > max ) {
+		printf("-%c expects a number from 1 to %lu, got %s\n", opt, max, arg);
+		exit(0);
+	}
+	return v;
+}
+
+void log_start(const SudokuContext &ctx) {
+	if ( ctx.options().batchsize ) {
+		fprintf(stderr, "%u threads, batch size %u\n", ctx.threads(), ctx.options().batchsize);
+	} else {
+		fprintf(stderr, "%u threads, batch size tuned to %lluus per batch\n", ctx.threads(), BatchSizer::target_ns/1000);
+	}
+}
+
+void log_end(const SudokuContext &ctx, size_t npuzzles, std::chrono::steady_clock::time_point start, bool verbose) {
+	unsigned long nbatches = ctx.nbatches, cells_resolved = ctx.cells_resolved;
+	unsigned long nbranches = ctx.nbranches, nbacktracks = ctx.nbacktracks;
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "%ld puzzles in %.3fs, %.0f puzzles/s, %lu batches of %.1f puzzles on average\n",
+		npuzzles, secs, npuzzles / secs, nbatches, nbatches ? (double)npuzzles / nbatches : 0.0);
+	if ( ctx.invalid_records ) {
+		fprintf(stderr, "%lu packed records have a cell above 9, written as having no solution\n",
+			(unsigned long)ctx.invalid_records);
+	}
+	if ( ctx.options().cache_size || ctx.options().cache_file ) {
+		unsigned long hits = ctx.cache_hits;
+		fprintf(stderr, "%lu puzzles answered from the solution cache (%.1f%%)\n",
+			hits, npuzzles ? 100.0 * hits / npuzzles : 0.0);
+	}
+	if ( verbose ) {
+		fprintf(stderr, "%ld puzzles, propagation resolved %lu empty cells (%.1f per puzzle)\n",
+			npuzzles, cells_resolved, npuzzles ? (double)cells_resolved / npuzzles : 0.0);
+		fprintf(stderr, "search: %lu branches, %lu backtracks (%.1f and %.1f per puzzle)\n",
+			nbranches, nbacktracks, npuzzles ? (double)nbranches / npuzzles : 0.0,
+			npuzzles ? (double)nbacktracks / npuzzles : 0.0);
+	}
 }
 
 
-//accepts up to 2 arguments: 
+//accepts options followed by up to 2 arguments:
+//  -e engine - solver engine, "dlinks" (exact cover, default), "compact" (exact cover on a
+//              matrix of 16-bit indices) or "bitboard" (candidate propagation)
+//  -t n      - number of threads, defaults to the number of hardware threads
+//  -b n      - fixed number of puzzles per batch, by default the batch size is tuned at runtime
+//  -u limit  - count the solutions of each puzzle up to limit (1-9) and append the count
+//              as a third column, -u 2 tells whether each puzzle has a unique solution
+//  -o format - output format, "text" (default) or "packed" solution records
+//  -s policy - durability of the output file: "none" (default) leaves it to the kernel, "end"
+//              syncs once all is written, a number of milliseconds syncs that often while writing
+//  -c n      - keep the solutions of up to n puzzles in a cache, so repeated puzzles and ones
+//              equivalent under relabeling, band and stack permutations and transposition
+//              are solved once (a puzzle with several solutions may get another one of them)
+//  -C file   - keep the solution cache in file across runs, an existing file keeps its size
+//  -k        - keep a checkpoint of the progress next to the output file (<output>.ckpt)
+//  -r        - resume an interrupted run from its checkpoint, and keep checkpointing; the
+//              per puzzle counters of a STATS=1 build are appended to those of the run resumed
+//  -p        - pin each thread to a core, with its workspace on the memory node of that core
+//              (on a reserved huge page if there are any) and a contiguous range of the puzzles
+//  -v        - print statistics to stderr after the run
 //  1 - file of puzzles, puzzles are a new-line delimited string of numbers with 0 representing empty boxes
-//      defaults to "puzzles.txt"
+//      or a packed puzzle file (see packed_format.hpp), defaults to "puzzles.txt", "-" reads stdin
 //  2 - output file, solution will be written to the output file in the same format as the input file
-//      defaults to "solutions.txt"
+//      defaults to "solutions.txt", or stdout when reading stdin; "-" writes to stdout
+//A regular input file is mapped and solved in place, stdin, pipes and other streams
+//(or output to stdout) are read and solved chunk by chunk with the output in input order.
 int main(int argc, char *argv[]) {
 
-	argv++; argc--;
+	SudokuContext::Options opts;
+	OutputWriter::Durability durability = OutputWriter::none;
+	unsigned int sync_ms = 0;
+	bool verbose = false;
+	bool checkpointing = false, resume = false;
+	int opt;
+	while ( (opt = getopt(argc, argv, "e:t:b:u:o:s:c:C:krpv")) != -1 ) {
+		switch ( opt ) {
+		case 'e':
+			if ( strcmp(optarg, "dlinks") == 0 ) {
+				opts.engine = SudokuContext::dlinks;
+			} else if ( strcmp(optarg, "compact") == 0 ) {
+				opts.engine = SudokuContext::compact;
+			} else if ( strcmp(optarg, "bitboard") == 0 ) {
+				opts.engine = SudokuContext::bitboard;
+			} else {
+				printf("Unknown engine %s, expected dlinks, compact or bitboard\n", optarg);
+				exit(0);
+			}
+			break;
+		case 't':
+			opts.nthreads = parse_count(opt, optarg, 4096);
+			break;
+		case 'b':
+			opts.batchsize = parse_count(opt, optarg, 1<<20);
+			break;
+		case 'u':
+			opts.count_limit = parse_count(opt, optarg, 9);
+			break;
+		case 'o':
+			if ( strcmp(optarg, "text") == 0 ) {
+				opts.packed_out = false;
+			} else if ( strcmp(optarg, "packed") == 0 ) {
+				opts.packed_out = true;
+			} else {
+				printf("Unknown output format %s, expected text or packed\n", optarg);
+				exit(0);
+			}
+			break;
+		case 's':
+			if ( strcmp(optarg, "none") == 0 ) {
+				durability = OutputWriter::none;
+			} else if ( strcmp(optarg, "end") == 0 ) {
+				durability = OutputWriter::at_end;
+			} else if ( isdigit((unsigned char)optarg[0]) ) {
+				sync_ms = parse_count(opt, optarg, 3600000);
+				durability = OutputWriter::periodic;
+			} else {
+				printf("Unknown sync policy %s, expected none, end or a number of milliseconds\n", optarg);
+				exit(0);
+			}
+			break;
+		case 'c':
+			opts.cache_size = parse_count(opt, optarg, 1UL<<32);
+			break;
+		case 'C':
+			opts.cache_file = optarg;
+			break;
+		case 'k':
+			checkpointing = true;
+			break;
+		case 'r':
+			checkpointing = resume = true;
+			break;
+		case 'p':
+			opts.pin = true;
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			printf("Usage: ss [-e dlinks|compact|bitboard] [-t threads] [-b batchsize] [-u limit] [-o text|packed] [-s none|end|ms] [-c entries] [-C cachefile] [-k] [-r] [-p] [-v] [puzzles.txt [solutions.txt]]\n");
+			exit(0);
+		}
+	}
+	argv += optind; argc -= optind;
+	SudokuContext ctx(opts);
+	if ( *ctx.cache_error() ) {
+		fprintf(stderr, "%s\n", ctx.cache_error());
+	}
 
 	const char *ifn = argc > 0? argv[0] : "puzzles.txt";
-	int fdin = open(ifn, O_RDONLY);
+	int fdin = strcmp(ifn, "-") == 0 ? 0 : open(ifn, O_RDONLY);
 	if ( fdin == -1 ) {
 		if (errno ) {
 			printf("Error opening file %s: %s\n", ifn, strerror(errno));
@@ -77,6 +376,27 @@ int main(int argc, char *argv[]) {
 	fstat(fdin, &sb);
     size_t fsize = sb.st_size;
 
+	const char *ofn = argc > 1? argv[1] : fdin == 0 ? "-" : "solutions.txt";
+	if ( !S_ISREG(sb.st_mode) || strcmp(ofn, "-") == 0 ) {
+		if ( checkpointing ) {
+			printf("Checkpoints need a regular input file and an output file\n");
+			exit(0);
+		}
+		int fdout = strcmp(ofn, "-") == 0 ? 1 : open(ofn, O_WRONLY|O_CREAT|O_TRUNC, 0775);
+		if ( fdout == -1 ) {
+			fprintf(stderr, "Error opening output file %s: %s\n", ofn, strerror(errno));
+			exit(0);
+		}
+		log_start(ctx);
+		auto start = std::chrono::steady_clock::now();
+		size_t npuzzles = stream_puzzles(ctx, fdin, fdout, ifn, ofn, durability, sync_ms);
+		log_end(ctx, npuzzles, start, verbose);
+		if ( fdout != 1 ) {
+			close(fdout);
+		}
+		return 0;
+	}
+
 	// map the input file
 	unsigned char *puzzlez = (unsigned char *)mmap((void*)0, fsize, PROT_READ, MAP_PRIVATE, fdin, 0);
 	if ( puzzlez == MAP_FAILED ) {
@@ -86,79 +406,101 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	// get and check the number of puzzles
-	size_t npuzzlesin = (fsize+1) / 82;
-	size_t npuzzlesread = 0;
-	if ( npuzzlesin * 82 != fsize+1 && npuzzlesin * 82 != fsize) {
-		printf("found %ld puzzles, but the file %s has %ld extra characters!\n",
-			npuzzlesin, argc?argv[0]:"puzzles.txt", (fsize+1 - npuzzlesin * 82));
+	// index the puzzles, this also brings the file into the page cache for the threads
+	PuzzleIndex index(ifn);
+	PackedHeader hdr;
+	std::vector<size_t> offsets;
+	bool packed = hdr.read(puzzlez, fsize);
+	if ( packed ) {
+		check_packed(hdr, ifn);
+		size_t used = index_packed(PackedHeader::size, fsize, offsets);
+		if ( used != fsize || (hdr.count != PackedHeader::unknown_count && hdr.count != offsets.size()) ) {
+			fprintf(stderr, "%s: header counts %ld puzzles, found %zu and %zu extra bytes\n",
+				ifn, (long)hdr.count, offsets.size(), fsize-used);
+		}
+	} else {
+		index.scan(puzzlez, 0, fsize, true, offsets);
+	}
+	size_t npuzzlesin = offsets.size();
+	if ( index.rejected ) {
+		fprintf(stderr, "%zu of %zu lines rejected\n", index.rejected, index.lines);
 	}
 
-	const char *ofn = argc > 1? argv[1] : "solutions.txt";
-	int fdout = open(ofn, O_RDWR|O_CREAT, 0775);
+	// the puzzles are solved in slices written at their own offsets, one per thread with -p
+	// a resumed run goes on with the slices of the checkpoint, a new one resets the checkpoint
+	// before it truncates the output
+	size_t outhdr = opts.packed_out ? PackedHeader::size : 0;	// bytes of header before the first solution
+	std::vector<OutputWriter::Slice> slices = OutputWriter::split(npuzzlesin, opts.pin ? ctx.threads() : 1);
+	bool resumed = false;
+	Checkpoint *checkpoint = nullptr;
+	if ( checkpointing ) {
+		checkpoint = new Checkpoint(ofn, Checkpoint::Record(sb, npuzzlesin, ctx.record_size(), opts.count_limit), durability != OutputWriter::none);
+		std::vector<OutputWriter::Slice> saved;
+		resumed = resume && checkpoint->resume(saved);
+		// the records of each slice up to its next must be in the output
+		size_t written = 0;
+		for ( const OutputWriter::Slice &s : saved ) {
+			written = s.next > s.begin && s.next > written ? s.next : written;
+		}
+		struct stat osb;
+		if ( resumed && (stat(ofn, &osb) == -1 || (size_t)osb.st_size < outhdr + written*ctx.record_size()) ) {
+			fprintf(stderr, "%s is shorter than checkpoint %s says, starting over\n", ofn, checkpoint->name());
+			resumed = false;
+		}
+		if ( resumed ) {
+			slices = saved;
+		}
+		checkpoint->begin(slices);
+	}
+	size_t npuzzles = 0;	// puzzles left to solve
+	for ( const OutputWriter::Slice &s : slices ) {
+		npuzzles += s.end - s.next;
+	}
+	// records after the checkpoint of a slice may be partly written, they are written again
+	int fdout = open(ofn, O_WRONLY|O_CREAT|(resumed ? 0 : O_TRUNC), 0775);
 	if ( fdout == -1 ) {
 		if (errno ) {
 			printf("Error opening output file %s: %s\n", ofn, strerror(errno));
 			exit(0);
 		}
 	}
-	if ( ftruncate(fdout, (size_t)npuzzlesin*164) == -1 ) {
-		if (errno ) {
-			printf("Error setting size (ftruncate) on output file %s: %s\n", ofn, strerror(errno));
-		}
-		exit(0);
-	}
-
-	// map the output file
-	unsigned char *solvedout = (unsigned char *)mmap((void*)0, npuzzlesin*164, PROT_WRITE, MAP_SHARED, fdout, 0);
-	if ( solvedout == MAP_FAILED ) {
-		if (errno ) {
-			printf("Error mmap of output file %s: %s\n", ofn, strerror(errno));
-			exit(0);
+	if ( resumed ) {
+		if ( npuzzles ) {
+			fprintf(stderr, "Resuming with %zu of %zu puzzles left\n", npuzzles, npuzzlesin);
+		} else {
+			fprintf(stderr, "All %zu puzzles were solved already\n", npuzzlesin);
 		}
 	}
-	close(fdout);
-
-	BlockingQueue<class Buf> bQ(64);
-
-	for (unsigned int i=0; i<nthreads; i++) {
-		auto bqp = &bQ;
-		threads[i] = new std::thread( [=]{ thread_loop(bqp); } );
+	if ( opts.packed_out ) {
+		unsigned char h[PackedHeader::size];
+		PackedHeader(PackedHeader::solutions, npuzzlesin).write(h);
+		write_full(fdout, h, sizeof(h), ofn);
 	}
 
-	unsigned int remaining;
-	unsigned int syncat = 0x2000;
-    while( (remaining = npuzzlesin-npuzzlesread) > 0 ) {
-		if ( remaining < batchsize ) {
-			batchsize = remaining;
-		}
-		if ( npuzzlesread > syncat ) {
-			if ( msync(solvedout, (syncat-64)*164-0x1000, MS_ASYNC) == -1 ) {
-				if (errno ) {
-					printf("Error msync of file %s: %s\n", ofn, strerror(errno));
-				}
-			}
-			syncat += 0x2000;
-		}
-
-		bQ.emplace_back(puzzlez+npuzzlesread*82, solvedout+npuzzlesread*164, batchsize);
-		// the following is actually a 'prefetch' of the file content
-		// for the threads benefit.  The message, while sensible, should never display
-		unsigned char x = puzzlez[npuzzlesread*82+81];
-		if ( x != '\n' ) {
-			printf("puzzle not NL-terminated\n");
-		}
-						
-		npuzzlesread += batchsize;
-	}
+	log_start(ctx);
+	auto start = std::chrono::steady_clock::now();
 
-	for (unsigned int i=0; i<nthreads; i++) {
-		bQ.put(Buf(0, 0, 0));
-	}
+	// a few batch buffers per thread keep the threads busy while the writer catches up
+	OutputWriter writer(fdout, ofn, outhdr, ctx.record_size(), slices, 4*ctx.threads(), durability, sync_ms);
+	writer.set_checkpoint(checkpoint);
+	PuzzleStats *pstats = nullptr;
+#ifdef SEARCH_STATS
+	std::vector<PuzzleStats> stats(npuzzlesin);
+	pstats = stats.data();
+#endif
+	ctx.solve_batch(puzzlez, offsets.data(), packed, npuzzlesin, nullptr, &writer, pstats);
+	writer.finish();
 
-	for (unsigned int i=0; i<nthreads; i++) {
-		threads[i]->join();
+	log_end(ctx, npuzzles, start, verbose);
+	close(fdout);
+	delete checkpoint;
+#ifdef SEARCH_STATS
+	StatsSidecar sidecar(ofn, resumed);
+	for ( const OutputWriter::Slice &s : slices ) {
+		sidecar.add(stats.data()+s.next, s.end-s.next, s.next);
 	}
+	sidecar.finish();
+#endif
 
 	int err = munmap(puzzlez, fsize);
 	if ( err == -1 ) {
@@ -166,11 +508,5 @@ int main(int argc, char *argv[]) {
 			printf("Error munmap file %s: %s\n", ifn, strerror(errno));
 		}
 	}
-	err = munmap(solvedout, (size_t)npuzzlesin*164);
-	if ( err == -1 ) {
-		if (errno ) {
-			printf("Error munmap file %s: %s\n", ofn, strerror(errno));
-		}
-	}
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <sched.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <new>
+#include <vector>
+
+//Placement of worker threads and their memory, for SudokuContext::Options::pin
+//A pinned thread stays on one core, and the default (local) NUMA policy puts a page on the
+//node of the thread that touches it first, so memory mapped and first written by a pinned
+//worker is node-local without any libnuma calls.
+
+static const size_t huge_page_size = 2<<20;
+
+//cpus the process may run on, in increasing order
+inline std::vector<int> allowed_cpus() {
+	std::vector<int> cpus;
+	cpu_set_t set;
+	if ( sched_getaffinity(0, sizeof(set), &set) == 0 ) {
+		for ( int i=0; i<CPU_SETSIZE; i++ ) {
+			if ( CPU_ISSET(i, &set) ) {
+				cpus.push_back(i);
+			}
+		}
+	}
+	return cpus;
+}
+
+//pin the calling thread to cpu, saving its previous affinity to old
+//returns false if the thread could not be pinned
+inline bool pin_thread(int cpu, cpu_set_t &old) {
+	if ( pthread_getaffinity_np(pthread_self(), sizeof(old), &old) != 0 ) {
+		return false;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+inline void restore_affinity(const cpu_set_t &old) {
+	pthread_setaffinity_np(pthread_self(), sizeof(old), &old);
+}
+
+//map size bytes from reserved huge pages, or else from normal pages, and touch them from the
+//calling thread; the workspaces are far below 2MB, so transparent huge pages would not back them
+//mapped receives the size to unmap; returns null if there is no memory
+inline void *map_local(size_t size, size_t &mapped) {
+	mapped = (size + huge_page_size-1) & ~(huge_page_size-1);
+	void *p = mmap(nullptr, mapped, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if ( p == MAP_FAILED ) {
+		mapped = size;
+		p = mmap(nullptr, mapped, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if ( p == MAP_FAILED ) {
+			return nullptr;
+		}
+	}
+	memset(p, 0, size);
+	return p;
+}
+
+//an object of class T in memory of the calling thread's node if local is set (see map_local),
+//otherwise or if nothing can be mapped one from new
+template<class T>
+class LocalPtr {
+	T *p;
+	size_t mapped;		// bytes mapped, 0 if p came from new
+
+	public:
+	LocalPtr(bool local) {
+		void *m = local ? map_local(sizeof(T), mapped) : nullptr;
+		if ( m ) {
+			p = new (m) T;
+		} else {
+			p = new T;
+			mapped = 0;
+		}
+	}
+
+	~LocalPtr() {
+		if ( mapped ) {
+			p->~T();
+			munmap(p, mapped);
+		} else {
+			delete p;
+		}
+	}
+
+	LocalPtr(const LocalPtr &) = delete;
+	LocalPtr &operator=(const LocalPtr &) = delete;
+
+	inline T *get() const { return p; }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+//Lock-free distribution of a range of work items among threads
+//Each thread claims the next chunk of items with an atomic fetch-add on a shared cursor,
+//so there is no producer and no handoff through a queue
+class WorkScheduler {
+	std::atomic<size_t> cursor;
+	size_t end;
+
+	public:
+	WorkScheduler(size_t begin, size_t end) : cursor(begin), end(end) {}
+
+	//claim up to n items starting at first
+	//returns the number of items claimed, 0 once the range is exhausted
+	inline size_t claim(size_t n, size_t &first) {
+		// skip the fetch-add once done, so the cursor can't run away past the range
+		if(cursor.load(std::memory_order_relaxed) >= end) {
+			return 0;
+		}
+		first = cursor.fetch_add(n, std::memory_order_relaxed);
+		if(first >= end) {
+			return 0;
+		}
+		return end-first < n ? end-first : n;
+	}
+
+	//number of items not claimed yet
+	inline size_t remaining() const {
+		size_t c = cursor.load(std::memory_order_relaxed);
+		return c < end ? end-c : 0;
+	}
+};
+
+//Per thread batch size, tuned from the measured time per item
+//Batches grow until one takes about target_ns, which keeps the cost of a claim a small
+//fraction of the work, and shrink towards the end of the range so the threads finish together
+class BatchSizer {
+	double ns_per_item;		// moving average of the measured time per item, 0 until measured
+	unsigned int fixed;		// batch size to use as is, 0 to tune
+
+	public:
+	static const unsigned int initial_size = 16;
+	static const unsigned int max_size = 4096;
+	static const unsigned long long target_ns = 200000;
+
+	BatchSizer(unsigned int fixed) : ns_per_item(0), fixed(fixed) {}
+
+	//size of the next batch, given the items left and the number of threads sharing them
+	inline size_t next(size_t remaining, unsigned int nthreads) {
+		if(fixed) {
+			return fixed;
+		}
+		size_t n = ns_per_item > 0 ? (size_t)(target_ns / ns_per_item) : initial_size;
+		if(n > max_size) {
+			n = max_size;
+		}
+		//leave a few batches per thread for the tail of the range
+		size_t tail = remaining / (4*nthreads);
+		if(n > tail) {
+			n = tail;
+		}
+		return n > 0 ? n : 1;
+	}
+
+	//record that a batch of n items took ns nanoseconds
+	inline void update(size_t n, unsigned long long ns) {
+		double x = (double)ns / n;
+		ns_per_item = ns_per_item > 0 ? 0.75*ns_per_item + 0.25*x : x;
+	}
+};